@@ -0,0 +1,21 @@
+#pragma once
+#include <chrono>
+#include <iostream>
+#include <string_view>
+
+namespace tre::benchmarks {
+	// Runs a function a number of times and prints the average time taken per run.
+	template <class Fn> void run(std::string_view name, std::size_t iterations, Fn&& fn);
+} // namespace tre::benchmarks
+
+template <class Fn> void tre::benchmarks::run(std::string_view name, std::size_t iterations, Fn&& fn)
+{
+	// The first run is discarded so that caches and allocations are warmed up.
+	fn();
+	const auto start{std::chrono::steady_clock::now()};
+	for (std::size_t i = 0; i < iterations; ++i) {
+		fn();
+	}
+	const std::chrono::duration<double, std::micro> elapsed{std::chrono::steady_clock::now() - start};
+	std::cout << name << ": " << elapsed.count() / iterations << " us\n";
+}
\ No newline at end of file
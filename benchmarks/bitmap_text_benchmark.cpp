@@ -0,0 +1,357 @@
+// Benchmarks laying out and meshing text with BitmapTextManager on the null graphics backend.
+//
+// Formatted paragraphs are meshed with createFormattedTextMesh and with a copy of the multi-pass meshing it replaced,
+// which split the text into lines, measured every line again for its alignment offset and decoded it a third time to
+// emit its quads. The copy uses the fixed alignment formula so that both emit the same quads, which is checked.
+//
+// Log-style text is measured and meshed once as plain ASCII, which goes through the vectorized plain ASCII scan, and
+// once with every 'e' replaced by 'é', which forces the same text through UTF-8 decoding, so that the difference
+// between the two is the gain of the fast path. Both glyphs have the same advance, so the two variants are also checked
+// to measure the same.
+
+#include "benchmark.hpp"
+#include <tre/bitmap_text_manager.hpp>
+
+namespace tre::benchmarks {
+	constexpr std::size_t LOG_LINES{2000};
+	constexpr std::size_t PARAGRAPHS{64};
+	constexpr std::size_t ITERATIONS{100};
+	constexpr float       TEXTBOX_WIDTH{800};
+
+	// Adds a monospace font covering ASCII and Latin-1 to a bitmap text manager.
+	void addMonospaceFont(tre::BitmapTextManager& manager);
+	// Creates log-style text: timestamped lines with paths, numbers and the occasional escaped backslash.
+	std::string logText(std::size_t lines, bool formatted);
+	// Creates formatted paragraphs of a few hundred characters with color and italic escapes.
+	std::vector<std::string> paragraphs(std::size_t count);
+	// Replaces every 'e' in a string with 'é'.
+	std::string latin1Text(std::string_view text);
+	// Splits a string into lines.
+	std::vector<std::string_view> splitLines(std::string_view text);
+
+	// The longest prefix of formatted text that fits within a width, as measured by the multi-pass meshing.
+	std::string_view referenceMeasure(std::string_view text, const tre::BitmapTextManager::Font& font, float scale,
+									  float maxWidth) noexcept;
+	// Splits formatted text into lines like the multi-pass meshing.
+	std::vector<std::string_view> referenceSplit(std::string_view text, const tre::BitmapTextManager::Font& font,
+												 float scale, float maxWidth);
+	// Measures a line of formatted text again for its alignment offset like the multi-pass meshing.
+	float referenceOffsetX(std::string_view line, const tre::BitmapTextManager::Font& font, float scale,
+						   const tre::BitmapTextManager::Textbox& textbox) noexcept;
+	// Appends the quad of a glyph to a mesh.
+	void referenceQuad(tre::BitmapTextManager::Mesh& mesh, const tre::BitmapTextManager::CompiledGlyph& glyph,
+					   tre::BitmapTextManager::Style style, glm::vec2 scale, tr::RGBA8 tint, glm::vec2 pen);
+	// Meshes formatted text like the multi-pass meshing.
+	tre::BitmapTextManager::Mesh referenceMesh(std::string_view text, const tre::BitmapTextManager::Font& font,
+											   glm::vec2 scale, std::span<const tr::RGBA8> colors,
+											   const tre::BitmapTextManager::Textbox& textbox);
+	// Benchmarks meshing paragraphs with createFormattedTextMesh against the multi-pass meshing, returning whether
+	// both emitted the same number of quads.
+	bool benchmarkParagraphs(tre::BitmapTextManager& manager, std::span<const std::string> paragraphs,
+							 tre::Align alignment);
+
+	// Benchmarks measuring a text as a whole and meshing it line by line, returning the metrics of the text.
+	tre::TextMetrics benchmarkLog(tre::BitmapTextManager& manager, std::string_view name, std::string_view text,
+								  bool formatted);
+} // namespace tre::benchmarks
+
+void tre::benchmarks::addMonospaceFont(tre::BitmapTextManager& manager)
+{
+	tre::BitmapTextManager::GlyphMap glyphs;
+	for (std::uint32_t codepoint = 0; codepoint < 256; ++codepoint) {
+		tre::BitmapTextManager::Glyph glyph;
+		glyph.x       = std::int32_t(codepoint % 16 * 8);
+		glyph.y       = std::int32_t(codepoint / 16 * 16);
+		glyph.width   = codepoint <= ' ' ? 0 : 8;
+		glyph.height  = codepoint <= ' ' ? 0 : 16;
+		glyph.xOffset = 0;
+		glyph.yOffset = 0;
+		glyph.advance = 8;
+		glyphs.emplace(codepoint, glyph);
+	}
+	// The null graphics backend ignores the font's bitmap.
+	manager.addFont("mono", tr::Bitmap{glm::ivec2{1, 1}}, 16, std::move(glyphs));
+}
+
+std::string tre::benchmarks::logText(std::size_t lines, bool formatted)
+{
+	constexpr std::array<std::string_view, 4> LEVELS{"INFO ", "DEBUG", "WARN ", "ERROR"};
+	// A formatted backslash has to be escaped.
+	const std::string_view separator{formatted ? "\\\\" : "\\"};
+
+	std::string text;
+	for (std::size_t i = 0; i < lines; ++i) {
+		text += std::format("[2024-05-{:02}T{:02}:{:02}:{:02}.{:03}] {} worker-{}: ", i % 28 + 1, i / 3600 % 24,
+							i / 60 % 60, i % 60, i * 7 % 1000, LEVELS[i % LEVELS.size()], i % 8);
+		if (i % 4 == 0) {
+			text += std::format("loaded C:{}games{}assets{}level_{}.dat in {} ms", separator, separator, separator, i,
+								i * 13 % 97);
+		}
+		else {
+			text += std::format("processed {} entities, queue depth {}, frame time {}.{} ms", i * 31 % 4096, i % 17,
+								i % 16, i * 3 % 10);
+		}
+		text += '\n';
+	}
+	return text;
+}
+
+std::vector<std::string> tre::benchmarks::paragraphs(std::size_t count)
+{
+	constexpr std::array<std::string_view, 12> WORDS{"the",  "quick",    "\\c1brown\\!", "fox",   "jumps",   "over",
+													 "lazy", "\\idog\\i", "while",        "seven", "wizards", "hexed"};
+
+	std::vector<std::string> result;
+	for (std::size_t i = 0; i < count; ++i) {
+		std::string paragraph;
+		for (std::size_t word = 0; paragraph.size() < 600; ++word) {
+			paragraph += WORDS[(i + word * 7) % WORDS.size()];
+			paragraph += word % 40 == 39 ? '\n' : ' ';
+		}
+		result.push_back(std::move(paragraph));
+	}
+	return result;
+}
+
+std::string tre::benchmarks::latin1Text(std::string_view text)
+{
+	std::string result;
+	for (char chr : text) {
+		if (chr == 'e') {
+			result += "\xC3\xA9"; // 'é' in UTF-8.
+		}
+		else {
+			result += chr;
+		}
+	}
+	return result;
+}
+
+std::string_view tre::benchmarks::referenceMeasure(std::string_view text, const tre::BitmapTextManager::Font& font,
+												   float scale, float maxWidth) noexcept
+{
+	float lineWidth{};
+	for (auto it = tr::utf8Begin(text); it != tr::utf8End(text); ++it) {
+		if (*it == '\n') {
+			return {text.begin(), (const char*)(it)};
+		}
+		else if (*it == '\\') {
+			if (++it != tr::utf8End(text) && *it == '\\') {
+				lineWidth += font.glyph('\\').advance * scale;
+			}
+		}
+		else {
+			lineWidth += font.glyph(*it).advance * scale;
+			if ((const char*)(it) != text.data() && lineWidth > maxWidth) {
+				return {text.begin(), (const char*)(it)};
+			}
+		}
+	}
+	return text;
+}
+
+std::vector<std::string_view> tre::benchmarks::referenceSplit(std::string_view text,
+															   const tre::BitmapTextManager::Font& font, float scale,
+															   float maxWidth)
+{
+	std::vector<std::string_view> lines;
+	while (true) {
+		const std::string_view fit{referenceMeasure(text, font, scale, maxWidth)};
+		if (fit.size() == text.size()) {
+			lines.push_back(fit);
+			return lines;
+		}
+		const std::size_t lastWhitespace{text.substr(0, fit.size() + 1).find_last_of(" \t\n")};
+		if (lastWhitespace != std::string_view::npos) {
+			lines.push_back(text.substr(0, lastWhitespace));
+			text.remove_prefix(lastWhitespace + 1);
+		}
+		else {
+			lines.push_back(fit);
+			text.remove_prefix(fit.size());
+		}
+	}
+}
+
+float tre::benchmarks::referenceOffsetX(std::string_view line, const tre::BitmapTextManager::Font& font, float scale,
+										const tre::BitmapTextManager::Textbox& textbox) noexcept
+{
+	const float textboxLeft{textbox.pos.x - textbox.posAnchor.x};
+	if (tre::HorizontalAlign(textbox.textAlignment) == tre::HorizontalAlign::LEFT) {
+		return textboxLeft;
+	}
+
+	float width{};
+	for (auto it = line.begin(); it != line.end(); ++it) {
+		if (*it == '\\') {
+			if (++it != line.end() && *it == '\\') {
+				width += font.glyph('\\').advance * scale;
+			}
+		}
+		else {
+			width += font.glyph(std::uint8_t(*it)).advance * scale;
+		}
+	}
+	return tre::HorizontalAlign(textbox.textAlignment) == tre::HorizontalAlign::CENTER
+			   ? textboxLeft + (textbox.size.x - width) / 2.0f
+			   : textboxLeft + textbox.size.x - width;
+}
+
+void tre::benchmarks::referenceQuad(tre::BitmapTextManager::Mesh&                 mesh,
+									const tre::BitmapTextManager::CompiledGlyph& glyph,
+									tre::BitmapTextManager::Style style, glm::vec2 scale, tr::RGBA8 tint, glm::vec2 pen)
+{
+	std::array<tr::TintVtx2, 4> quad;
+	const glm::vec2             size{glyph.size * scale};
+	tr::fillRectVertices((quad | tr::positions).begin(), pen + glyph.offset * scale, size);
+	if (style == tre::BitmapTextManager::Style::ITALIC) {
+		constexpr double TAN_12_5_DEG{0.22169466264};
+		quad[0].pos.x += size.y * TAN_12_5_DEG;
+		quad[3].pos.x += size.y * TAN_12_5_DEG;
+	}
+	tr::fillRectVertices((quad | tr::uvs).begin(), glyph.uv.tl, glyph.uv.size);
+	std::ranges::fill(quad | tr::colors, tint);
+	tr::fillPolygonIndices(std::back_inserter(mesh.indices), 4, std::uint16_t(mesh.vertices.size()));
+	mesh.vertices.insert(mesh.vertices.end(), quad.begin(), quad.end());
+}
+
+tre::BitmapTextManager::Mesh tre::benchmarks::referenceMesh(std::string_view text,
+															const tre::BitmapTextManager::Font& font, glm::vec2 scale,
+															std::span<const tr::RGBA8>             colors,
+															const tre::BitmapTextManager::Textbox& textbox)
+{
+	tre::BitmapTextManager::Mesh  mesh;
+	tre::BitmapTextManager::Style style{tre::BitmapTextManager::Style::NORMAL};
+	tr::RGBA8                     tint{255, 255, 255, 255};
+	float                         yOffset{textbox.pos.y - textbox.posAnchor.y};
+	for (std::string_view line : referenceSplit(text, font, scale.x, textbox.size.x)) {
+		float xOffset{referenceOffsetX(line, font, scale.x, textbox)};
+		for (auto it = line.begin(); it != line.end(); ++it) {
+			if (*it == '\\' && ++it != line.end()) {
+				switch (*it) {
+				case '!':
+					tint = {255, 255, 255, 255};
+					continue;
+				case 'c':
+					if (++it != line.end() && std::isdigit(*it) && std::size_t(*it - '0') < colors.size()) {
+						tint = colors[*it - '0'];
+					}
+					continue;
+				case 'i':
+					style = style == tre::BitmapTextManager::Style::NORMAL ? tre::BitmapTextManager::Style::ITALIC
+																		   : tre::BitmapTextManager::Style::NORMAL;
+					continue;
+				case '\\':
+					break;
+				default:
+					continue;
+				}
+			}
+			const tre::BitmapTextManager::CompiledGlyph& glyph{font.glyph(std::uint8_t(*it))};
+			if (glyph.size.x != 0 && glyph.size.y != 0) {
+				referenceQuad(mesh, glyph, style, scale, tint, {xOffset, yOffset});
+			}
+			xOffset += glyph.advance * scale.x;
+		}
+		yOffset += font.lineSkip * scale.y;
+	}
+	return mesh;
+}
+
+bool tre::benchmarks::benchmarkParagraphs(tre::BitmapTextManager& manager, std::span<const std::string> paragraphs,
+										  tre::Align alignment)
+{
+	const tre::BitmapTextManager::Font&   font{manager.font("mono")};
+	const tre::BitmapTextManager::Textbox textbox{{}, {}, {TEXTBOX_WIDTH / 2, 0}, {}, alignment};
+	std::array<tr::RGBA8, 2>              colors{{{255, 255, 255, 255}, {255, 0, 0, 255}}};
+	std::size_t                           layoutVertices{0};
+	std::size_t                           referenceVertices{0};
+
+	tre::benchmarks::run(std::format("createFormattedTextMesh, alignment {}", int(alignment)), ITERATIONS, [&] {
+		layoutVertices = 0;
+		for (const std::string& paragraph : paragraphs) {
+			const tre::BitmapTextManager::Mesh mesh{
+				manager.createFormattedTextMesh(paragraph, "mono", {1, 1}, colors, textbox)};
+			layoutVertices += mesh.vertices.size();
+		}
+	});
+	tre::benchmarks::run(std::format("Multi-pass meshing, alignment {}", int(alignment)), ITERATIONS, [&] {
+		referenceVertices = 0;
+		for (const std::string& paragraph : paragraphs) {
+			referenceVertices += referenceMesh(paragraph, font, {1, 1}, colors, textbox).vertices.size();
+		}
+	});
+	return layoutVertices == referenceVertices;
+}
+
+std::vector<std::string_view> tre::benchmarks::splitLines(std::string_view text)
+{
+	std::vector<std::string_view> lines;
+	while (!text.empty()) {
+		const std::size_t end{std::min(text.find('\n'), text.size())};
+		lines.push_back(text.substr(0, end));
+		text.remove_prefix(std::min(end + 1, text.size()));
+	}
+	return lines;
+}
+
+tre::TextMetrics tre::benchmarks::benchmarkLog(tre::BitmapTextManager& manager, std::string_view name,
+											   std::string_view text, bool formatted)
+{
+	const tre::BitmapTextManager::Textbox textbox{{}, {}, {TEXTBOX_WIDTH, 0}, {}, tre::Align::TOP_LEFT};
+	const std::vector<std::string_view> lines{splitLines(text)};
+	std::vector<float>                  lineWidths(text.size());
+	std::vector<tr::RGBA8>              colors;
+	tre::TextMetrics                    metrics;
+
+	tre::benchmarks::run(std::format("Measure {} ({} bytes)", name, text.size()), ITERATIONS, [&] {
+		if (formatted) {
+			metrics = manager.measureFormattedText(lineWidths, text, "mono", {1, 1}, TEXTBOX_WIDTH);
+		}
+		else {
+			metrics = manager.measureUnformattedText(lineWidths, text, "mono", {1, 1}, TEXTBOX_WIDTH);
+		}
+	});
+	tre::benchmarks::run(std::format("Mesh {} line by line", name), ITERATIONS, [&] {
+		for (std::string_view line : lines) {
+			if (formatted) {
+				manager.createFormattedTextMesh(line, "mono", {1, 1}, colors, textbox);
+			}
+			else {
+				manager.createUnformattedTextMesh(line, "mono", tre::BitmapTextManager::Style::NORMAL, {1, 1},
+												  {255, 255, 255, 255}, textbox);
+			}
+		}
+	});
+	return metrics;
+}
+
+int main()
+{
+	tre::BitmapTextManager manager{tre::NULL_GRAPHICS};
+	tre::benchmarks::addMonospaceFont(manager);
+
+	const std::vector<std::string> paragraphs{tre::benchmarks::paragraphs(tre::benchmarks::PARAGRAPHS)};
+	for (tre::Align alignment : {tre::Align::TOP_LEFT, tre::Align::TOP_CENTER, tre::Align::TOP_RIGHT}) {
+		if (!tre::benchmarks::benchmarkParagraphs(manager, paragraphs, alignment)) {
+			std::cerr << "createFormattedTextMesh and the multi-pass meshing emitted different quads.\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	const std::string unformatted{tre::benchmarks::logText(tre::benchmarks::LOG_LINES, false)};
+	const std::string formatted{tre::benchmarks::logText(tre::benchmarks::LOG_LINES, true)};
+	const std::array<tre::TextMetrics, 4> metrics{
+		tre::benchmarks::benchmarkLog(manager, "ASCII log", unformatted, false),
+		tre::benchmarks::benchmarkLog(manager, "Latin-1 log", tre::benchmarks::latin1Text(unformatted), false),
+		tre::benchmarks::benchmarkLog(manager, "formatted ASCII log", formatted, true),
+		tre::benchmarks::benchmarkLog(manager, "formatted Latin-1 log", tre::benchmarks::latin1Text(formatted), true),
+	};
+	for (std::size_t i = 0; i < metrics.size(); i += 2) {
+		if (metrics[i].lines != metrics[i + 1].lines || metrics[i].size != metrics[i + 1].size) {
+			std::cerr << "ASCII and Latin-1 text measured differently.\n";
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
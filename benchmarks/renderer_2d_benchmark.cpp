@@ -0,0 +1,132 @@
+// Benchmarks preparing and drawing frames with Renderer2D on the null graphics backend, and checks that every frame
+// records the same graphics calls, as state tracked between frames would otherwise cause calls to be skipped.
+//
+// Also checks, by evaluating the blending equations on the CPU, that translucent primitives blended into a layer cache
+// and composited come out the same as when blended directly.
+
+#include "benchmark.hpp"
+#include <tre/renderer_2d.hpp>
+
+namespace tre::benchmarks {
+	constexpr int         LAYERS{64};
+	constexpr std::size_t QUADS_PER_LAYER{256};
+	constexpr std::size_t SHAPES_PER_LAYER{16};
+	constexpr std::size_t FRAMES{1000};
+
+	// Evaluates a blending mode with the ADD function for a source and destination color.
+	glm::vec4 blend(const tr::BlendMode& blendMode, glm::vec4 src, glm::vec4 dst);
+	// Checks that translucent primitives look the same when blended into a layer cache and composited.
+	bool cachedBlendingMatches();
+
+	void addLayers(tre::Renderer2D& renderer);
+	void submitFrame(tre::Renderer2D& renderer);
+} // namespace tre::benchmarks
+
+glm::vec4 tre::benchmarks::blend(const tr::BlendMode& blendMode, glm::vec4 src, glm::vec4 dst)
+{
+	const auto factor{[&](tr::BlendMultiplier multiplier) {
+		switch (multiplier) {
+		case tr::BlendMultiplier::ZERO:
+			return 0.0f;
+		case tr::BlendMultiplier::ONE:
+			return 1.0f;
+		case tr::BlendMultiplier::SRC_ALPHA:
+			return src.w;
+		case tr::BlendMultiplier::ONE_MINUS_SRC_ALPHA:
+			return 1 - src.w;
+		default:
+			std::abort();
+		}
+	}};
+
+	assert(blendMode.rgbFn == tr::BlendFunction::ADD && blendMode.alphaFn == tr::BlendFunction::ADD);
+	const float rgbSrc{factor(blendMode.rgbSrc)};
+	const float rgbDst{factor(blendMode.rgbDst)};
+	return {src.x * rgbSrc + dst.x * rgbDst, src.y * rgbSrc + dst.y * rgbDst, src.z * rgbSrc + dst.z * rgbDst,
+			src.w * factor(blendMode.alphaSrc) + dst.w * factor(blendMode.alphaDst)};
+}
+
+bool tre::benchmarks::cachedBlendingMatches()
+{
+	const std::array<glm::vec4, 3> primitives{{{1, 0, 0, 0.5f}, {0, 1, 0, 0.25f}, {0, 0, 1, 0.75f}}};
+	const glm::vec4                destination{0.2f, 0.4f, 0.6f, 1};
+	const tr::BlendMode            premultiplied{tre::Renderer2D::CACHE_COMPOSITE_BLENDING};
+
+	for (const tr::BlendMode& blendMode : {tr::ALPHA_BLENDING, premultiplied}) {
+		glm::vec4 uncached{destination};
+		glm::vec4 cache{0, 0, 0, 0};
+		for (glm::vec4 primitive : primitives) {
+			if (blendMode == premultiplied) {
+				primitive = {primitive.x * primitive.w, primitive.y * primitive.w, primitive.z * primitive.w,
+							 primitive.w};
+			}
+			uncached = blend(blendMode, primitive, uncached);
+			cache    = blend(*tre::Renderer2D::cacheBlendMode(blendMode), primitive, cache);
+		}
+		const glm::vec4 cached{blend(tre::Renderer2D::CACHE_COMPOSITE_BLENDING, cache, destination)};
+		for (int i = 0; i < 4; ++i) {
+			if (std::abs(cached[i] - uncached[i]) > 1e-5f) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void tre::benchmarks::addLayers(tre::Renderer2D& renderer)
+{
+	for (int layer = 0; layer < LAYERS; ++layer) {
+		// Every other layer shares a transform, so that consecutive layers always need a transform change.
+		const float scale{layer % 2 == 0 ? 1.0f : 0.5f};
+		renderer.addColorOnlyLayer(layer, glm::mat4{scale}, tr::ALPHA_BLENDING);
+	}
+}
+
+void tre::benchmarks::submitFrame(tre::Renderer2D& renderer)
+{
+	const std::array<glm::vec2, 4> polyline{{{-0.5f, -0.5f}, {0.0f, 0.5f}, {0.5f, -0.5f}, {0.75f, 0.0f}}};
+	for (int layer = 0; layer < LAYERS; ++layer) {
+		for (std::size_t i = 0; i < QUADS_PER_LAYER; ++i) {
+			const glm::vec2 pos{i % 16 / 8.0f - 1, i / 16 / 8.0f - 1};
+			tre::Renderer2D::ColorQuad quad;
+			tr::fillRectVertices((quad | tr::positions).begin(), pos, {0.1f, 0.1f});
+			std::ranges::fill(quad | tr::colors, tr::RGBA8{255, 255, 255, 255});
+			renderer.addColorQuad(layer, quad);
+		}
+		for (std::size_t i = 0; i < SHAPES_PER_LAYER; ++i) {
+			renderer.addColorCircle(layer, {0, 0}, 0.05f * (i + 1), {255, 0, 0, 255});
+			renderer.addColorPolyline(layer, polyline, 0.01f, {0, 255, 0, 255});
+		}
+	}
+}
+
+int main()
+{
+	if (!tre::benchmarks::cachedBlendingMatches()) {
+		std::cerr << "Cached translucent layers blend differently than uncached ones.\n";
+		return EXIT_FAILURE;
+	}
+
+	tre::Renderer2D renderer{tre::NULL_GRAPHICS};
+	tre::benchmarks::addLayers(renderer);
+
+	tre::benchmarks::submitFrame(renderer);
+	renderer.prepare();
+	renderer.drawPrepared(tre::NULL_GRAPHICS);
+	const std::vector<tre::GraphicsCall> firstFrame{renderer.recordedCalls()};
+	std::cout << "Draw calls per frame: " << renderer.stats().drawCalls << '\n';
+
+	bool consistent{true};
+	tre::benchmarks::run("Submit, prepare and draw a frame", tre::benchmarks::FRAMES, [&] {
+		renderer.clearRecordedCalls();
+		tre::benchmarks::submitFrame(renderer);
+		renderer.prepare();
+		renderer.drawPrepared(tre::NULL_GRAPHICS);
+		consistent = consistent && renderer.recordedCalls() == firstFrame;
+	});
+	if (!consistent) {
+		std::cerr << "Frames recorded different graphics calls.\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
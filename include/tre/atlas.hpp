@@ -47,6 +47,11 @@ namespace tre {
 	 ******************************************************************************************************************/
 	class Atlas2D {
 	  public:
+		/**************************************************************************************************************
+		 * Handle to an atlas entry, which can be looked up without hashing the name of the entry.
+		 **************************************************************************************************************/
+		enum class Handle : std::uint32_t {};
+
 		/**************************************************************************************************************
 		 * Uploads a pre-made atlas bitmap.
 		 *
@@ -108,6 +113,34 @@ namespace tre {
 		 **************************************************************************************************************/
 		const tr::RectF2& operator[](std::string_view name) const noexcept;
 
+		/**************************************************************************************************************
+		 * Gets the handle to an entry.
+		 *
+		 * @param[in] name
+		 * @parblock
+		 * The name of the entry.
+		 *
+		 * @pre The entry must exist in the atlas.
+		 * @endparblock
+		 *
+		 * @return A handle to the entry, valid for the lifetime of the atlas.
+		 **************************************************************************************************************/
+		Handle handle(std::string_view name) const noexcept;
+
+		/**************************************************************************************************************
+		 * Returns the rect associated with an entry.
+		 *
+		 * @param[in] handle
+		 * @parblock
+		 * The handle to the entry.
+		 *
+		 * @pre @em handle must have been obtained from this atlas.
+		 * @endparblock
+		 *
+		 * @return The entry rect with normalized size and coordinates.
+		 **************************************************************************************************************/
+		const tr::RectF2& operator[](Handle handle) const noexcept;
+
 		/**************************************************************************************************************
 		 * Sets the debug label of the atlas texture.
 		 *
@@ -116,8 +149,9 @@ namespace tre {
 		void setLabel(std::string_view label) noexcept;
 
 	  private:
-		tr::Texture2D                 _tex;
-		tr::StringHashMap<tr::RectF2> _entries;
+		tr::Texture2D             _tex;
+		tr::StringHashMap<Handle> _handles;
+		std::vector<tr::RectF2>   _entries;
 	};
 
 	/******************************************************************************************************************
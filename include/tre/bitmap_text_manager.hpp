@@ -2,6 +2,12 @@
 #include "atlas.hpp"
 #include "renderer_2d.hpp"
 #include "text.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
 #include <tref/tref.hpp>
 
 namespace tre {
@@ -30,8 +36,42 @@ namespace tre {
 		using Glyph    = tref::Glyph;
 		using GlyphMap = tref::GlyphMap;
 
+		/**************************************************************************************************************
+		 * Precomputed glyph information used when laying out and meshing text.
+		 **************************************************************************************************************/
+		struct CompiledGlyph {
+			/**********************************************************************************************************
+			 * The offset of the glyph from the pen position, in unscaled pixels.
+			 **********************************************************************************************************/
+			glm::vec2 offset;
+
+			/**********************************************************************************************************
+			 * The size of the glyph, in unscaled pixels.
+			 **********************************************************************************************************/
+			glm::vec2 size;
+
+			/**********************************************************************************************************
+			 * The normalized UV rectangle of the glyph within the manager's texture atlas.
+			 **********************************************************************************************************/
+			tr::RectF2 uv;
+
+			/**********************************************************************************************************
+			 * The distance the pen advances after the glyph, in unscaled pixels.
+			 **********************************************************************************************************/
+			float advance;
+
+			/**********************************************************************************************************
+			 * The index of the glyph in the manager's glyph table (see glyphTable()).
+			 **********************************************************************************************************/
+			std::uint32_t index;
+		};
+
 		/**************************************************************************************************************
 		 * Bitmap font information.
+		 *
+		 * When a font is added, its glyphs are compiled into a flat table indexed by codepoint for ASCII and Latin-1,
+		 * with a sparse table for the remaining codepoints, so that looking up a glyph doesn't require hashing in the
+		 * common case.
 		 **************************************************************************************************************/
 		struct Font {
 			/**********************************************************************************************************
@@ -44,6 +84,16 @@ namespace tre {
 			 **********************************************************************************************************/
 			GlyphMap glyphs;
 
+			/**********************************************************************************************************
+			 * Gets the compiled information of a glyph.
+			 *
+			 * @param codepoint The codepoint of the glyph, doesn't have to be in the font.
+			 *
+			 * @return The compiled glyph of @em codepoint, or that of the fallback glyph ('\0') if @em codepoint
+			 *         isn't in the font.
+			 **********************************************************************************************************/
+			const CompiledGlyph& glyph(std::uint32_t codepoint) const noexcept;
+
 			/**********************************************************************************************************
 			 * Determines if a glyph has an associated texture to it when drawing (i.e: it is not whitespace).
 			 *
@@ -53,6 +103,16 @@ namespace tre {
 			 *         codepoint isn't in the glyph.
 			 **********************************************************************************************************/
 			bool glyphDrawable(std::uint32_t codepoint) const noexcept;
+
+		  private:
+			// The number of codepoints covered by the dense table (ASCII and Latin-1).
+			static constexpr std::size_t DENSE_GLYPHS{256};
+
+			std::array<CompiledGlyph, DENSE_GLYPHS>          _denseGlyphs;
+			std::unordered_map<std::uint32_t, CompiledGlyph> _sparseGlyphs;
+			CompiledGlyph                                    _fallbackGlyph;
+
+			friend class BitmapTextManager;
 		};
 
 		/**************************************************************************************************************
@@ -120,11 +180,138 @@ namespace tre {
 			std::vector<std::uint16_t> indices;
 		};
 
+		/**************************************************************************************************************
+		 * Packed glyph record used for instanced text rendering.
+		 *
+		 * A glyph instance is about a quarter of the size of the vertices and indices of a glyph quad. Its size and
+		 * texture coordinates are looked up in the glyph table (see glyphTable()) when drawing, see BitmapTextRenderer.
+		 **************************************************************************************************************/
+		struct GlyphInstance {
+			/**********************************************************************************************************
+			 * The position of the pen of the glyph, with the rotation of the textbox already applied.
+			 **********************************************************************************************************/
+			glm::vec2 pos;
+
+			/**********************************************************************************************************
+			 * The scale of the glyph, packed as two half-precision floats (see glm::packHalf2x16).
+			 **********************************************************************************************************/
+			std::uint32_t scale;
+
+			/**********************************************************************************************************
+			 * The cosine and sine of the rotation of the glyph, packed as two normalized 16-bit integers
+			 * (see glm::packSnorm2x16).
+			 **********************************************************************************************************/
+			std::uint32_t rotation;
+
+			/**********************************************************************************************************
+			 * The index of the glyph in the glyph table, with ITALIC_GLYPH_INSTANCE set if the glyph is italic.
+			 **********************************************************************************************************/
+			std::uint32_t glyph;
+
+			/**********************************************************************************************************
+			 * The tint of the glyph.
+			 **********************************************************************************************************/
+			tr::RGBA8 tint;
+		};
+
+		/**************************************************************************************************************
+		 * Flag set in GlyphInstance::glyph for italic glyphs.
+		 **************************************************************************************************************/
+		static constexpr std::uint32_t ITALIC_GLYPH_INSTANCE{0x80000000};
+
+		/**************************************************************************************************************
+		 * A request for a text mesh, used by createTextMeshes().
+		 **************************************************************************************************************/
+		struct TextRequest {
+			/**********************************************************************************************************
+			 * The text to draw (newlines are allowed). See @ref renderformat for the specifics of the text format if
+			 * the text is formatted.
+			 **********************************************************************************************************/
+			std::string_view text;
+
+			/**********************************************************************************************************
+			 * The name of the font to use.
+			 *
+			 * @pre @em font must be a valid font name.
+			 **********************************************************************************************************/
+			std::string_view font;
+
+			/**********************************************************************************************************
+			 * Whether the text is formatted.
+			 **********************************************************************************************************/
+			bool formatted{false};
+
+			/**********************************************************************************************************
+			 * Parsed formatted text to draw in place of @em text, or nullptr.
+			 *
+			 * If set, @em text and @em formatted are ignored. Bold, underlined and striked out runs are drawn normally.
+			 **********************************************************************************************************/
+			const RichText* richText{nullptr};
+
+			/**********************************************************************************************************
+			 * The style of unformatted text.
+			 **********************************************************************************************************/
+			Style style{Style::NORMAL};
+
+			/**********************************************************************************************************
+			 * The scale of the text.
+			 **********************************************************************************************************/
+			glm::vec2 scale{1, 1};
+
+			/**********************************************************************************************************
+			 * The tint of unformatted text.
+			 **********************************************************************************************************/
+			tr::RGBA8 tint{255, 255, 255, 255};
+
+			/**********************************************************************************************************
+			 * The available colors of formatted text.
+			 **********************************************************************************************************/
+			std::span<const tr::RGBA8> colors{};
+
+			/**********************************************************************************************************
+			 * The textbox to frame the text around.
+			 **********************************************************************************************************/
+			Textbox textbox;
+		};
+
+		/**************************************************************************************************************
+		 * Laid out text that can be revealed progressively and appended to.
+		 **************************************************************************************************************/
+		class LaidOutText;
+
+		/**************************************************************************************************************
+		 * Text mesh cache counters.
+		 **************************************************************************************************************/
+		struct MeshCacheCounters {
+			/**********************************************************************************************************
+			 * The number of cached mesh requests that were served from the cache.
+			 **********************************************************************************************************/
+			std::size_t hits{0};
+
+			/**********************************************************************************************************
+			 * The number of cached mesh requests that had to build a new mesh.
+			 **********************************************************************************************************/
+			std::size_t misses{0};
+		};
+
+		/**************************************************************************************************************
+		 * The default memory budget of the text mesh cache in bytes.
+		 **************************************************************************************************************/
+		static constexpr std::size_t DEFAULT_MESH_CACHE_BUDGET{1 << 20};
+
 		/**************************************************************************************************************
 		 * Constructs the bitmap text manager.
 		 **************************************************************************************************************/
 		BitmapTextManager() noexcept;
 
+		/**************************************************************************************************************
+		 * Constructs the bitmap text manager with the null graphics backend.
+		 *
+		 * The manager doesn't create a texture atlas, so it can be used without a tr::Window. Font bitmaps are
+		 * ignored and the UVs of compiled glyphs are left empty, but text is laid out and meshed as usual.
+		 **************************************************************************************************************/
+		explicit BitmapTextManager(NullGraphics) noexcept;
+
 		/**************************************************************************************************************
 		 * Move-constructs a bitmap text manager.
 		 *
@@ -141,6 +328,8 @@ namespace tre {
 		/**************************************************************************************************************
 		 * Gets a reference to the manager's texture atlas.
 		 *
+		 * @pre The manager must not have been created with the null graphics backend.
+		 *
 		 * @return An immutable reference to the manager's texture atlas.
 		 **************************************************************************************************************/
 		const tr::Texture2D& texture() const noexcept;
@@ -188,6 +377,23 @@ namespace tre {
 		 **************************************************************************************************************/
 		void loadFont(std::string name, const std::filesystem::path& path);
 
+		/**************************************************************************************************************
+		 * Gets the glyph table.
+		 *
+		 * The glyph table contains the compiled information of every glyph of every font, and is what glyph instances
+		 * index into. It is rebuilt whenever a font is added or removed, which invalidates existing glyph instances.
+		 *
+		 * @return A span over the glyph table.
+		 **************************************************************************************************************/
+		std::span<const CompiledGlyph> glyphTable() const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the generation of the glyph table.
+		 *
+		 * @return A number that changes every time the glyph table is rebuilt.
+		 **************************************************************************************************************/
+		std::size_t glyphTableGeneration() const noexcept;
+
 		/**************************************************************************************************************
 		 * Removes a font from the renderer.
 		 *
@@ -272,20 +478,812 @@ namespace tre {
 		Mesh createFormattedTextMesh(std::string_view text, std::string_view font, glm::vec2 scale,
 									 std::span<tr::RGBA8> colors, const Textbox& textbox);
 
-	  private:
-		struct CachedRotationTransform {
-			glm::vec2  pos{};
-			tr::AngleF rotation{};
-			glm::mat4  transform{};
-		};
+		/**************************************************************************************************************
+		 * Creates a mesh for parsed formatted, multistyle text.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The parsed text to draw. Bold, underlined and striked out runs are drawn normally.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 *
+		 * @return A text mesh.
+		 **************************************************************************************************************/
+		Mesh createFormattedTextMesh(const RichText& text, std::string_view font, glm::vec2 scale,
+									 std::span<tr::RGBA8> colors, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Lays out unformatted, single-style text so that it can be revealed progressively and appended to.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The text to draw (newlines are allowed).
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] style The style of the text to use.
+		 * @param[in] scale The scale of the text.
+		 * @param[in] tint The tint of the text.
+		 * @param[in] textbox The textbox to frame the text around.
+		 *
+		 * @return The laid out text.
+		 **************************************************************************************************************/
+		LaidOutText layOutUnformattedText(std::string_view text, std::string_view font, Style style, glm::vec2 scale,
+										  tr::RGBA8 tint, const Textbox& textbox) const;
+
+		/**************************************************************************************************************
+		 * Lays out formatted, multistyle text so that it can be revealed progressively and appended to.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The text to draw (newlines are allowed). See @ref renderformat for the specifics of the text
+		 *                 format.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 *
+		 * @return The laid out text.
+		 **************************************************************************************************************/
+		LaidOutText layOutFormattedText(std::string_view text, std::string_view font, glm::vec2 scale,
+										std::span<const tr::RGBA8> colors, const Textbox& textbox) const;
+
+		/**************************************************************************************************************
+		 * Lays out parsed formatted, multistyle text so that it can be revealed progressively and appended to.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The parsed text to draw. Bold, underlined and striked out runs are drawn normally.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 *
+		 * @return The laid out text.
+		 **************************************************************************************************************/
+		LaidOutText layOutFormattedText(const RichText& text, std::string_view font, glm::vec2 scale,
+										std::span<const tr::RGBA8> colors, const Textbox& textbox) const;
+
+		/**************************************************************************************************************
+		 * Creates meshes for a batch of texts, spreading the work across several threads.
+		 *
+		 * The work is handed to worker threads owned by the manager, which are started the first time they're needed
+		 * and kept for later calls.
+		 *
+		 * Unlike the other mesh creation functions, this function doesn't use any state of the manager besides its
+		 * fonts and worker threads, so it may be called concurrently from several threads as long as no fonts are
+		 * added or removed at the same time.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 * @exception std::system_error If a worker thread couldn't be started or locking a mutex fails.
+		 *
+		 * @param[in] requests The texts to create meshes for.
+		 * @param[in] threads
+		 * @parblock
+		 * The maximum number of threads to use, including the calling thread. Small batches may use fewer threads.
+		 *
+		 * @pre @em threads must be greater than 0.
+		 * @endparblock
+		 *
+		 * @return The meshes of the texts, in the same order as @em requests.
+		 **************************************************************************************************************/
+		std::vector<Mesh> createTextMeshes(std::span<const TextRequest> requests, unsigned int threads = 1) const;
+
+		/**************************************************************************************************************
+		 * Adds unformatted, single-style text to a 2D renderer layer.
+		 *
+		 * The glyph quads are written directly into the layer's storage, without building an intermediate mesh.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to draw the text on.
+		 *
+		 * @pre The 2D renderer must be instantiated and have a layer with priority @em layer.
+		 *
+		 * @pre The layer must use the texture of the bitmap text manager and a sampler.
+		 * @endparblock
+		 * @param[in] text The text to draw (newlines are allowed).
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] style The style of the text to use.
+		 * @param[in] scale The scale of the text.
+		 * @param[in] tint The tint of the text.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void addUnformattedText(int layer, std::string_view text, std::string_view font, Style style, glm::vec2 scale,
+								tr::RGBA8 tint, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Adds formatted, multistyle text to a 2D renderer layer.
+		 *
+		 * The glyph quads are written directly into the layer's storage, without building an intermediate mesh.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to draw the text on.
+		 *
+		 * @pre The 2D renderer must be instantiated and have a layer with priority @em layer.
+		 *
+		 * @pre The layer must use the texture of the bitmap text manager and a sampler.
+		 * @endparblock
+		 * @param[in] text The text to draw (newlines are allowed). See @ref renderformat for the specifics of the text
+		 *                 format.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void addFormattedText(int layer, std::string_view text, std::string_view font, glm::vec2 scale,
+							  std::span<tr::RGBA8> colors, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Adds parsed formatted, multistyle text to a 2D renderer layer.
+		 *
+		 * The glyph quads are written directly into the layer's storage, without building an intermediate mesh.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to draw the text on.
+		 *
+		 * @pre The 2D renderer must be instantiated and have a layer with priority @em layer.
+		 *
+		 * @pre The layer must use the texture of the bitmap text manager and a sampler.
+		 * @endparblock
+		 * @param[in] text The parsed text to draw. Bold, underlined and striked out runs are drawn normally.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void addFormattedText(int layer, const RichText& text, std::string_view font, glm::vec2 scale,
+							  std::span<tr::RGBA8> colors, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Writes the glyph quads of unformatted, single-style text into caller-provided storage.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[out] quads The storage to write the quads into. If it is too small, only the first quads are written.
+		 * @param[in] text The text to draw (newlines are allowed).
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] style The style of the text to use.
+		 * @param[in] scale The scale of the text.
+		 * @param[in] tint The tint of the text.
+		 * @param[in] textbox The textbox to frame the text around.
+		 *
+		 * @return The number of quads of the text, which may be larger than the size of @em quads.
+		 **************************************************************************************************************/
+		std::size_t writeUnformattedTextQuads(std::span<GlyphMesh> quads, std::string_view text, std::string_view font,
+											  Style style, glm::vec2 scale, tr::RGBA8 tint, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Writes the glyph quads of formatted, multistyle text into caller-provided storage.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[out] quads The storage to write the quads into. If it is too small, only the first quads are written.
+		 * @param[in] text The text to draw (newlines are allowed). See @ref renderformat for the specifics of the text
+		 *                 format.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 *
+		 * @return The number of quads of the text, which may be larger than the size of @em quads.
+		 **************************************************************************************************************/
+		std::size_t writeFormattedTextQuads(std::span<GlyphMesh> quads, std::string_view text, std::string_view font,
+											glm::vec2 scale, std::span<tr::RGBA8> colors, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Writes the glyph quads of parsed formatted, multistyle text into caller-provided storage.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[out] quads The storage to write the quads into. If it is too small, only the first quads are written.
+		 * @param[in] text The parsed text to draw. Bold, underlined and striked out runs are drawn normally.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 *
+		 * @return The number of quads of the text, which may be larger than the size of @em quads.
+		 **************************************************************************************************************/
+		std::size_t writeFormattedTextQuads(std::span<GlyphMesh> quads, const RichText& text, std::string_view font,
+											glm::vec2 scale, std::span<tr::RGBA8> colors, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Appends glyph instances of unformatted, single-style text to a vector.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[out] instances The vector to append the glyph instances to.
+		 * @param[in] text The text to draw (newlines are allowed).
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] style The style of the text to use.
+		 * @param[in] scale The scale of the text.
+		 * @param[in] tint The tint of the text.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void appendUnformattedTextInstances(std::vector<GlyphInstance>& instances, std::string_view text,
+											std::string_view font, Style style, glm::vec2 scale, tr::RGBA8 tint,
+											const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Appends glyph instances of formatted, multistyle text to a vector.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[out] instances The vector to append the glyph instances to.
+		 * @param[in] text The text to draw (newlines are allowed). See @ref renderformat for the specifics of the text
+		 *                 format.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void appendFormattedTextInstances(std::vector<GlyphInstance>& instances, std::string_view text,
+										  std::string_view font, glm::vec2 scale, std::span<tr::RGBA8> colors,
+										  const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Appends glyph instances of parsed formatted, multistyle text to a vector.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[out] instances The vector to append the glyph instances to.
+		 * @param[in] text The parsed text to draw. Bold, underlined and striked out runs are drawn normally.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void appendFormattedTextInstances(std::vector<GlyphInstance>& instances, const RichText& text,
+										  std::string_view font, glm::vec2 scale, std::span<tr::RGBA8> colors,
+										  const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Measures unformatted, single-style text without meshing it.
+		 *
+		 * The text is laid out into storage reused between calls, so measuring doesn't allocate once it has grown large
+		 * enough.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[out] lineWidths
+		 * @parblock
+		 * The storage to write the widths of the lines into. If it is too small, only the widths of the first lines are
+		 * written.
+		 * @endparblock
+		 * @param[in] text The text to measure (newlines are allowed).
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] maxWidth The width lines are broken at, like the width of a textbox.
+		 *
+		 * @return The metrics of the text.
+		 **************************************************************************************************************/
+		TextMetrics measureUnformattedText(std::span<float> lineWidths, std::string_view text, std::string_view font,
+										   glm::vec2 scale, float maxWidth);
+
+		/**************************************************************************************************************
+		 * Measures formatted, multistyle text without meshing it.
+		 *
+		 * The text is laid out into storage reused between calls, so measuring doesn't allocate once it has grown large
+		 * enough.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[out] lineWidths
+		 * @parblock
+		 * The storage to write the widths of the lines into. If it is too small, only the widths of the first lines are
+		 * written.
+		 * @endparblock
+		 * @param[in] text The text to measure (newlines are allowed). See @ref renderformat for the specifics of the
+		 *                 text format.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] maxWidth The width lines are broken at, like the width of a textbox.
+		 *
+		 * @return The metrics of the text.
+		 **************************************************************************************************************/
+		TextMetrics measureFormattedText(std::span<float> lineWidths, std::string_view text, std::string_view font,
+										 glm::vec2 scale, float maxWidth);
+
+		/**************************************************************************************************************
+		 * Measures parsed formatted, multistyle text without meshing it.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[out] lineWidths
+		 * @parblock
+		 * The storage to write the widths of the lines into. If it is too small, only the widths of the first lines are
+		 * written.
+		 * @endparblock
+		 * @param[in] text The parsed text to measure.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] maxWidth The width lines are broken at, like the width of a textbox.
+		 *
+		 * @return The metrics of the text.
+		 **************************************************************************************************************/
+		TextMetrics measureFormattedText(std::span<float> lineWidths, const RichText& text, std::string_view font,
+										 glm::vec2 scale, float maxWidth);
+
+		/**************************************************************************************************************
+		 * Gets a cached mesh for unformatted, single-style text, creating it if it isn't in the cache.
+		 *
+		 * The mesh is identified by all of the arguments. When the cache goes over its memory budget, the least
+		 * recently used meshes are evicted.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The text to draw (newlines are allowed).
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] style The style of the text to use.
+		 * @param[in] scale The scale of the text.
+		 * @param[in] tint The tint of the text.
+		 * @param[in] textbox The textbox to frame the text around.
+		 *
+		 * @return A reference to the cached text mesh. The reference stays valid until the mesh is evicted, which can
+		 *         only happen during a later call to a cached mesh function, setMeshCacheBudget(), clearMeshCache() or
+		 *         a function that adds or removes fonts.
+		 **************************************************************************************************************/
+		const Mesh& cachedUnformattedTextMesh(std::string_view text, std::string_view font, Style style,
+											  glm::vec2 scale, tr::RGBA8 tint, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Gets a cached mesh for formatted, multistyle text, creating it if it isn't in the cache.
+		 *
+		 * The mesh is identified by all of the arguments. When the cache goes over its memory budget, the least
+		 * recently used meshes are evicted.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The text to draw (newlines are allowed). See @ref renderformat for the specifics of the text
+		 *                 format.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 *
+		 * @return A reference to the cached text mesh. The reference stays valid until the mesh is evicted, which can
+		 *         only happen during a later call to a cached mesh function, setMeshCacheBudget(), clearMeshCache() or
+		 *         a function that adds or removes fonts.
+		 **************************************************************************************************************/
+		const Mesh& cachedFormattedTextMesh(std::string_view text, std::string_view font, glm::vec2 scale,
+											std::span<tr::RGBA8> colors, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Gets a cached mesh for parsed formatted, multistyle text, creating it if it isn't in the cache.
+		 *
+		 * The mesh is identified by the plain text and runs of @em text and the rest of the arguments. When the cache
+		 * goes over its memory budget, the least recently used meshes are evicted.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The parsed text to draw. Bold, underlined and striked out runs are drawn normally.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 *
+		 * @return A reference to the cached text mesh. The reference stays valid until the mesh is evicted, which can
+		 *         only happen during a later call to a cached mesh function, setMeshCacheBudget(), clearMeshCache() or
+		 *         a function that adds or removes fonts.
+		 **************************************************************************************************************/
+		const Mesh& cachedFormattedTextMesh(const RichText& text, std::string_view font, glm::vec2 scale,
+											std::span<tr::RGBA8> colors, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Sets the memory budget of the text mesh cache.
+		 *
+		 * The most recently used mesh is always kept, even if it alone goes over the budget.
+		 *
+		 * @param[in] bytes The maximum amount of memory used by cached meshes in bytes.
+		 **************************************************************************************************************/
+		void setMeshCacheBudget(std::size_t bytes) noexcept;
+
+		/**************************************************************************************************************
+		 * Evicts all meshes from the text mesh cache.
+		 **************************************************************************************************************/
+		void clearMeshCache() noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the text mesh cache hit and miss counters.
+		 *
+		 * @return The counters of cache hits and misses since the last reset.
+		 **************************************************************************************************************/
+		const MeshCacheCounters& meshCacheCounters() const noexcept;
+
+		/**************************************************************************************************************
+		 * Resets the text mesh cache hit and miss counters.
+		 **************************************************************************************************************/
+		void resetMeshCacheCounters() noexcept;
+
+	  private:
+		struct CachedRotationTransform {
+			glm::vec2  pos{};
+			tr::AngleF rotation{};
+			glm::mat4  transform{};
+		};
+
+		// A decoded glyph of laid out text.
+		struct LayoutGlyph {
+			enum class Kind : std::uint8_t {
+				GLYPH,
+				BREAKABLE, // Spaces and tabs, which lines may be broken at.
+				NEWLINE
+			};
+
+			const CompiledGlyph* glyph;
+			tr::RGBA8            tint;
+			Style                style;
+			Kind                 kind;
+		};
+
+		// A line of laid out text, referencing a range of glyphs.
+		struct LayoutLine {
+			std::size_t begin;
+			std::size_t end;
+			float       width;
+		};
+
+		// The style and tint formatted text is decoded with.
+		struct FormatState {
+			Style     style{Style::NORMAL};
+			tr::RGBA8 tint{255, 255, 255, 255};
+		};
+
+		// Laid out text.
+		struct Layout {
+			std::vector<LayoutGlyph> glyphs;
+			std::vector<LayoutLine>  lines;
+
+			// Decodes unformatted text into glyphs.
+			void decodeUnformatted(std::string_view text, const Font& font, Style style, tr::RGBA8 tint);
+			// Decodes formatted text into glyphs.
+			void decodeFormatted(std::string_view text, const Font& font, std::span<const tr::RGBA8> colors);
+			// Decodes parsed formatted text into glyphs.
+			void decodeRich(const RichText& text, const Font& font, std::span<const tr::RGBA8> colors);
+			// Decodes parsed formatted text into glyphs appended to the existing ones.
+			void appendRich(const RichText& text, const Font& font, std::span<const tr::RGBA8> colors,
+							FormatState& state);
+			// Appends a glyph for a codepoint.
+			void appendGlyph(std::uint32_t codepoint, const Font& font, Style style, tr::RGBA8 tint);
+			// Decodes unformatted text into glyphs appended to the existing ones.
+			void appendUnformatted(std::string_view text, const Font& font, Style style, tr::RGBA8 tint);
+			// Decodes text into glyphs appended to the existing ones, stopping at the first backslash if the text is
+			// formatted, and returns the length of the decoded text.
+			std::size_t appendPlain(std::string_view text, const Font& font, Style style, tr::RGBA8 tint,
+									bool formatted);
+			// Decodes formatted text into glyphs appended to the existing ones, returning the incomplete escape
+			// sequence the text ended with, if any.
+			std::string_view appendFormatted(std::string_view text, const Font& font, std::span<const tr::RGBA8> colors,
+											 FormatState& state);
+			// Breaks the decoded glyphs into lines, starting over from an existing line.
+			void breakLines(float scale, float maxWidth, std::size_t firstLine = 0);
+			// Gets the number of quads needed to draw the layout.
+			std::size_t quadCount() const noexcept;
+			// Calls a function with every drawable glyph from a line onwards and the position of its pen.
+			template <class Fn>
+			void forEachQuad(glm::vec2 scale, float lineSkip, const Textbox& textbox, Fn fn,
+							 std::size_t firstLine = 0) const;
+			// Writes the layout to preallocated mesh storage.
+			void writeMesh(std::span<tr::TintVtx2> vertices, std::span<std::uint16_t> indices, glm::vec2 scale,
+						   float lineSkip, const Textbox& textbox) const;
+			// Creates a mesh from the layout.
+			Mesh createMesh(glm::vec2 scale, float lineSkip, const Textbox& textbox) const;
+			// Writes as many quads of the layout as fit into a span.
+			void writeQuads(std::span<GlyphMesh> quads, glm::vec2 scale, float lineSkip, const Textbox& textbox) const;
+			// Writes the layout directly into a 2D renderer layer.
+			void addToLayer(int layer, glm::vec2 scale, float lineSkip, const Textbox& textbox) const;
+			// Appends the glyph instances of the layout to a vector.
+			void appendInstances(std::vector<GlyphInstance>& instances, glm::vec2 scale, float lineSkip,
+								 const Textbox& textbox) const;
+			// Measures the layout, writing as many line widths as fit into a span.
+			TextMetrics measure(std::span<float> lineWidths, glm::vec2 scale, float lineSkip) const noexcept;
+		};
+
+		// The parameters a text mesh is created with.
+		struct TextMeshKey {
+			// The plain text if the text is parsed.
+			std::string_view           text;
+			std::string_view           font;
+			bool                       formatted;
+			Style                      style;
+			tr::RGBA8                  tint;
+			std::span<const tr::RGBA8> colors;
+			glm::vec2                  scale;
+			const Textbox&             textbox;
+			const RichText*            richText{nullptr};
+		};
+
+		struct CachedTextMesh {
+			std::size_t            hash;
+			std::string            text;
+			std::string            font;
+			bool                   formatted;
+			Style                  style;
+			tr::RGBA8              tint;
+			std::vector<tr::RGBA8> colors;
+			// The runs of the text if it was parsed.
+			std::vector<RichText::Run> runs;
+			glm::vec2                  scale;
+			Textbox                    textbox;
+			Mesh                       mesh;
+			std::size_t                bytes;
+		};
+
+		// Worker threads running jobs for createTextMeshes().
+		class WorkerPool {
+		  public:
+			// Starts workers until there are at least a given number of them.
+			void reserve(std::size_t workers);
+			// Queues a batch of jobs, none of which are queued if an exception is thrown.
+			void run(std::span<std::function<void()>> jobs);
+
+		  private:
+			std::mutex                        _mutex;
+			std::condition_variable_any       _jobQueued;
+			std::deque<std::function<void()>> _jobs;
+			// Declared last so that the workers are stopped and joined first.
+			std::vector<std::jthread> _workers;
+
+			void work(std::stop_token stop);
+		};
+
+		// Text mesh cache, with entries ordered from most to least recently used.
+		struct MeshCache {
+			std::list<CachedTextMesh>                                                 entries;
+			std::unordered_multimap<std::size_t, std::list<CachedTextMesh>::iterator> index;
+			std::size_t                                                               bytes{0};
+			std::size_t                                                               budget{DEFAULT_MESH_CACHE_BUDGET};
+			MeshCacheCounters                                                         counters;
+		};
+
+		// Empty under the null graphics backend.
+		std::optional<DynAtlas2D>  _atlas;
+		tr::StringHashMap<Font>    _fonts;
+		std::vector<CompiledGlyph> _glyphTable;
+		std::size_t                _glyphTableGeneration{0};
+		CachedRotationTransform    _cachedRotationTransform;
+		// Layout storage reused by the single-text functions.
+		Layout                     _layout;
+		MeshCache                  _meshCache;
+		// Held by pointer to keep the manager movable.
+		std::unique_ptr<WorkerPool> _workerPool;
+
+		// Writes the quad of a glyph with its pen at a position, optionally transformed.
+		static void writeGlyphMesh(std::span<tr::TintVtx2, 4> quad, const CompiledGlyph& glyph, Style style,
+								   glm::vec2 scale, tr::RGBA8 tint, glm::vec2 pen,
+								   const glm::mat4* transform) noexcept;
+		// Lays out unformatted text, returning the font that was used.
+		const Font& layoutUnformatted(Layout& layout, std::string_view text, std::string_view font, Style style,
+									  float scale, tr::RGBA8 tint, float maxWidth) const;
+		// Lays out formatted text, returning the font that was used.
+		const Font& layoutFormatted(Layout& layout, std::string_view text, std::string_view font, float scale,
+									std::span<const tr::RGBA8> colors, float maxWidth) const;
+		// Lays out parsed formatted text, returning the font that was used.
+		const Font& layoutRich(Layout& layout, const RichText& text, std::string_view font, float scale,
+							   std::span<const tr::RGBA8> colors, float maxWidth) const;
+		// Looks up a text mesh in the cache, creating and inserting it on a miss.
+		const Mesh& cachedTextMesh(const TextMeshKey& key);
+		// Evicts the least recently used meshes until the cache is within its budget.
+		void trimMeshCache() noexcept;
+
+		// Gets whether the manager uses the null graphics backend.
+		bool nullGraphics() const noexcept;
+		// Compiles the glyph tables of a font, adding its glyphs to the glyph table.
+		void compileFont(std::string_view name, Font& font);
+		// Rebuilds the glyph table and recompiles every font.
+		void compileFonts();
+	};
+
+	/******************************************************************************************************************
+	 * Laid out bitmap text that can be revealed progressively and appended to.
+	 *
+	 * The text is laid out and meshed once, with the quads of the glyphs stored in text order, so revealing the first
+	 * glyphs only requires drawing a prefix of the mesh's indices (see revealedIndexCount()). Appending text only
+	 * decodes the new text and lays out the last line again. The quads of the earlier lines are kept as well if the
+	 * text is aligned to the top-left of its textbox, since their positions can't change.
+	 *
+	 * Glyphs are counted in decoded characters, including whitespace and newlines but not formatting sequences.
+	 *
+	 * @warning The laid out text references the glyphs of its font, so it may not be appended to after fonts are added
+	 *          to or removed from the bitmap text manager.
+	 ******************************************************************************************************************/
+	class BitmapTextManager::LaidOutText {
+	  public:
+		/**************************************************************************************************************
+		 * Appends text to the end of the laid out text.
+		 *
+		 * Formatted text is decoded as a continuation of the existing text, so the current style and tint carry over
+		 * and escape sequences may be split across calls.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The text to append. It is formatted if the text was laid out with layOutFormattedText().
+		 **************************************************************************************************************/
+		void append(std::string_view text);
+
+		/**************************************************************************************************************
+		 * Appends parsed formatted text to the end of the laid out text.
+		 *
+		 * The tint of the existing text carries over until a run of the appended text sets its color.
+		 *
+		 * @pre The text must have been laid out with layOutFormattedText().
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The parsed text to append. Bold, underlined and striked out runs are drawn normally.
+		 **************************************************************************************************************/
+		void append(const RichText& text);
+
+		/**************************************************************************************************************
+		 * Gets the number of glyphs of the text.
+		 *
+		 * @return The number of glyphs of the text.
+		 **************************************************************************************************************/
+		std::size_t glyphCount() const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the mesh of the whole text.
+		 *
+		 * @return A reference to the mesh of the text, valid until the next call to append().
+		 **************************************************************************************************************/
+		const Mesh& mesh() const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the number of indices needed to draw the first glyphs of the text.
+		 *
+		 * The indices to draw are a prefix of the mesh's indices, and only reference a prefix of its vertices, with 4
+		 * vertices for every 6 indices.
+		 *
+		 * @param[in] glyphs The number of glyphs to reveal. Values greater than glyphCount() reveal the whole text.
+		 *
+		 * @return The number of indices needed to draw the first @em glyphs glyphs.
+		 **************************************************************************************************************/
+		std::size_t revealedIndexCount(std::size_t glyphs) const noexcept;
+
+		/**************************************************************************************************************
+		 * Adds the first glyphs of the text to a 2D renderer layer.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to draw the text on.
+		 *
+		 * @pre The 2D renderer must be instantiated and have a layer with priority @em layer.
+		 *
+		 * @pre The layer must use the texture of the bitmap text manager and a sampler.
+		 * @endparblock
+		 * @param[in] glyphs The number of glyphs to reveal. Values greater than glyphCount() reveal the whole text.
+		 **************************************************************************************************************/
+		void addToLayer(int layer, std::size_t glyphs) const;
+
+	  private:
+		const Font*                _font;
+		bool                       _formatted;
+		std::vector<tr::RGBA8>     _colors;
+		FormatState                _formatState;
+		// An escape sequence left incomplete at the end of the appended text.
+		std::string                _pendingEscape;
+		glm::vec2                  _scale;
+		Textbox                    _textbox;
+		Layout                     _layout;
+		Mesh                       _mesh;
+		// The number of quads before every glyph, with an extra entry for the end of the text.
+		std::vector<std::uint32_t> _quadsBefore;
+
+		LaidOutText(const Font& font, bool formatted, std::span<const tr::RGBA8> colors, FormatState formatState,
+					glm::vec2 scale, const Textbox& textbox);
 
-		DynAtlas2D              _atlas;
-		tr::StringHashMap<Font> _fonts;
-		CachedRotationTransform _cachedRotationTransform;
+		// Breaks appended glyphs into lines and meshes them, starting from the line that was last before appending.
+		void layOutAppended(std::size_t firstLine);
+		// Meshes the text again starting from a line.
+		void remesh(std::size_t firstLine);
 
-		GlyphMesh createGlyphMesh(std::uint32_t codepoint, const Font& font, tr::RectF2 fontUV, Style style,
-								  glm::vec2 scale, tr::RGBA8 tint, glm::vec2 pos, glm::vec2 posAnchor,
-								  tr::AngleF rotation);
+		friend class BitmapTextManager;
 	};
 
 	/******************************************************************************************************************
@@ -0,0 +1,166 @@
+#pragma once
+#include "bitmap_text_manager.hpp"
+
+namespace tre {
+	/** @addtogroup bitmap_text
+	 *  @{
+	 */
+
+	/******************************************************************************************************************
+	 * Instanced bitmap text renderer.
+	 *
+	 * Every glyph is stored as a single packed BitmapTextManager::GlyphInstance, whose metrics are looked up in the
+	 * bitmap text manager's glyph table by the vertex shader, so the amount of data uploaded per glyph is about a
+	 * quarter of that of a glyph quad. All glyphs of a renderer are drawn in a single instanced draw using the
+	 * rendering configuration (sampler, transformation matrix, blending mode) of a Renderer2D layer. Glyphs are kept
+	 * until clear() is called and are only reuploaded when they change, so static text costs nothing to draw again.
+	 *
+	 * Glyph instances index into the glyph table of the bitmap text manager, so the renderer must be cleared and its
+	 * text added again after adding or removing fonts.
+	 *
+	 * @note An instance of tr::Window must be created before BitmapTextRenderer can be instantiated.
+	 ******************************************************************************************************************/
+	class BitmapTextRenderer {
+	  public:
+		/**************************************************************************************************************
+		 * Creates an empty bitmap text renderer.
+		 *
+		 * @exception tr::GLBufferBadAlloc If an internal allocation fails.
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 **************************************************************************************************************/
+		BitmapTextRenderer();
+
+		/**************************************************************************************************************
+		 * Move-constructs a bitmap text renderer.
+		 *
+		 * @param[in] r The renderer to move from. @em r will be left in a moved-from state that shouldn't be used.
+		 **************************************************************************************************************/
+		BitmapTextRenderer(BitmapTextRenderer&& r) noexcept;
+
+		/**************************************************************************************************************
+		 * Destroys the bitmap text renderer.
+		 **************************************************************************************************************/
+		~BitmapTextRenderer() noexcept;
+
+		/**************************************************************************************************************
+		 * Adds unformatted, single-style text to the renderer.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The text to draw (newlines are allowed).
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre The bitmap text manager must be instantiated and @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] style The style of the text to use.
+		 * @param[in] scale The scale of the text.
+		 * @param[in] tint The tint of the text.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void addUnformattedText(std::string_view text, std::string_view font, BitmapTextManager::Style style,
+								glm::vec2 scale, tr::RGBA8 tint, const BitmapTextManager::Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Adds formatted, multistyle text to the renderer.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The text to draw (newlines are allowed). See @ref renderformat for the specifics of the text
+		 *                 format.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre The bitmap text manager must be instantiated and @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void addFormattedText(std::string_view text, std::string_view font, glm::vec2 scale,
+							  std::span<tr::RGBA8> colors, const BitmapTextManager::Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Adds parsed formatted, multistyle text to the renderer.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] text The parsed text to draw. Bold, underlined and striked out runs are drawn normally.
+		 * @param[in] font
+		 * @parblock
+		 * The name of the font to use.
+		 *
+		 * @pre The bitmap text manager must be instantiated and @em font must be a valid font name.
+		 * @endparblock
+		 * @param[in] scale The scale of the text.
+		 * @param[in] colors The available text colors. By default, a white tint not in the span is used.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void addFormattedText(const RichText& text, std::string_view font, glm::vec2 scale,
+							  std::span<tr::RGBA8> colors, const BitmapTextManager::Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Gets the number of glyphs in the renderer.
+		 *
+		 * @return The number of drawable glyphs added since the last clear.
+		 **************************************************************************************************************/
+		std::size_t glyphCount() const noexcept;
+
+		/**************************************************************************************************************
+		 * Removes all glyphs from the renderer.
+		 **************************************************************************************************************/
+		void clear() noexcept;
+
+		/**************************************************************************************************************
+		 * Draws the glyphs of the renderer.
+		 *
+		 * @exception tr::GLBufferBadAlloc If an internal allocation fails.
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] view The view to draw to.
+		 * @param[in] layer
+		 * @parblock
+		 * The Renderer2D layer whose sampler, transformation matrix and blending mode are used. The texture of the
+		 * bitmap text manager is used in place of the layer's texture.
+		 *
+		 * @pre The 2D renderer must be instantiated and have a layer with priority @em layer.
+		 *
+		 * @pre The layer must not be color-only.
+		 *
+		 * @pre No fonts may have been added to or removed from the bitmap text manager since the glyphs were added.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void draw(const RenderView& view, int layer);
+
+	  private:
+		struct ShaderGlyphMetrics {
+			glm::vec2 offset;
+			glm::vec2 size;
+			glm::vec2 uvTL;
+			glm::vec2 uvSize;
+		};
+
+		tr::OwningShaderPipeline _shaderPipeline;
+		tr::ShaderBuffer         _shaderGlyphBuffer;
+		tr::ShaderBuffer         _glyphMetricsBuffer;
+		tr::TextureUnit          _textureUnit;
+		tr::VertexFormat         _vertexFormat;
+		tr::VertexBuffer         _vertexBuffer;
+
+		std::vector<BitmapTextManager::GlyphInstance> _glyphs;
+		// Whether the glyphs changed since they were last uploaded.
+		bool _glyphsDirty;
+		// The glyph table generation the glyphs were added with.
+		std::size_t _glyphsGeneration;
+		// The glyph table generation of the uploaded glyph metrics.
+		std::optional<std::size_t> _metricsGeneration;
+
+		void uploadGlyphs();
+		void uploadGlyphMetrics();
+		void setupContext(const tr::BlendMode& blendMode) noexcept;
+	};
+
+	/// @}
+} // namespace tre
\ No newline at end of file
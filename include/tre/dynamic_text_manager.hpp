@@ -22,6 +22,14 @@ namespace tre {
 	 * DynamicTextManager is move-constructible, but neither copyable nor assignable. A moved renderer is left in a
 	 * state where another renderer can be moved into it, but is otherwise unusable.
 	 *
+	 * Rendered strings are kept in the atlas across frames and reused when the same string is created again with the
+	 * same parameters. Strings that weren't created for a number of frames (see setStringCacheLifetime()) are evicted
+	 * from the atlas by newFrame().
+	 *
+	 * Besides rendering whole strings into the atlas, the manager can build text out of glyph quads (see
+	 * addGlyphCachedUnformatted()). Every glyph is rasterized once per font, size, style and outline into a persistent
+	 * glyph atlas, so text that changes every frame only costs meshing.
+	 *
 	 * @note An instance of tr::Window must be created before DynamicTextManager can be instantiated.
 	 ******************************************************************************************************************/
 	class DynamicTextManager {
@@ -56,6 +64,11 @@ namespace tre {
 			Align textAlignment;
 		};
 
+		/**************************************************************************************************************
+		 * The default number of frames a string stays cached for without being created again.
+		 **************************************************************************************************************/
+		static constexpr unsigned int DEFAULT_STRING_CACHE_LIFETIME{60};
+
 		/**************************************************************************************************************
 		 * Constructs the dynamic text manager.
 		 **************************************************************************************************************/
@@ -81,6 +94,36 @@ namespace tre {
 		 **************************************************************************************************************/
 		const tr::Texture2D& texture() const noexcept;
 
+		/**************************************************************************************************************
+		 * Gets a reference to the manager's glyph atlas.
+		 *
+		 * Layers that glyph-cached text is added to must use this texture.
+		 *
+		 * @return An immutable reference to the manager's glyph atlas.
+		 **************************************************************************************************************/
+		const tr::Texture2D& glyphTexture() const noexcept;
+
+		/**************************************************************************************************************
+		 * Reserves space in the glyph atlas.
+		 *
+		 * The texture coordinates of glyph-cached text are normalized, so the glyph atlas may not grow once
+		 * glyph-cached text was added in a frame. Reserving enough space up front lets glyphs first used later in a
+		 * frame be rasterized without growing the atlas.
+		 *
+		 * @note If the requested capacity is smaller than the current capacity, this function does nothing.
+		 *
+		 * @exception tr::TextureBadAlloc If a texture reallocation happens and fails.
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] capacity
+		 * @parblock
+		 * The new capacity of the glyph atlas.
+		 *
+		 * @pre No glyph-cached text may have been added since the last call to newFrame() if this grows the atlas.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void reserveGlyphAtlas(glm::ivec2 capacity);
+
 		/**************************************************************************************************************
 		 * Sets the DPI of the renderer.
 		 *
@@ -190,17 +233,195 @@ namespace tre {
 												const Textbox& textbox);
 
 		/**************************************************************************************************************
-		 * Prepares the manager for a new frame.
+		 * Adds unformatted, single-style text built out of cached glyphs to a layer of the 2D renderer.
+		 *
+		 * Glyphs that aren't in the glyph cache yet are rasterized and added to it. Glyphs are laid out individually,
+		 * so kerning isn't applied. The outlines of all glyphs are drawn before their fills, so that an outline never
+		 * covers the fill of the previous glyph.
+		 *
+		 * @exception tr::BitmapBadAlloc If an internal allocation fails.
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to add the text to.
+		 *
+		 * @pre The 2D renderer must be instantiated and have a layer with priority @em layer that uses glyphTexture().
+		 *
+		 * @pre If glyph-cached text was already added since the last call to newFrame(), the glyph atlas must have
+		 *      room for any glyphs of the text that aren't cached yet (see reserveGlyphAtlas()).
+		 * @endparblock
+		 * @param[in] text The text string.
+		 * @param[in] font The font to use for the text.
+		 * @param[in] fontSize The font size to use for the text.
+		 * @param[in] style The font style to use for the text.
+		 * @param[in] textColor The color to use for the text.
+		 * @param[in] outline The outline parameters to use for the text, or NO_OUTLINE.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void addGlyphCachedUnformatted(int layer, std::string_view text, tr::TTFont& font, int fontSize,
+									   tr::TTFont::Style style, tr::RGBA8 textColor, TextOutline outline,
+									   const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Adds formatted, multistyle text built out of cached glyphs to a layer of the 2D renderer.
+		 *
+		 * Glyphs that aren't in the glyph cache yet are rasterized and added to it. Glyphs are laid out individually,
+		 * so kerning isn't applied. The outlines of all glyphs are drawn before their fills, so that an outline never
+		 * covers the fill of the previous glyph.
+		 *
+		 * @exception tr::BitmapBadAlloc If an internal allocation fails.
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to add the text to.
+		 *
+		 * @pre The 2D renderer must be instantiated and have a layer with priority @em layer that uses glyphTexture().
+		 *
+		 * @pre If glyph-cached text was already added since the last call to newFrame(), the glyph atlas must have
+		 *      room for any glyphs of the text that aren't cached yet (see reserveGlyphAtlas()).
+		 * @endparblock
+		 * @param[in] text The text string. See @ref renderformat for the specifics of the text format.
+		 * @param[in] font The font to use for the text.
+		 * @param[in] fontSize The font size to use for the text.
+		 * @param[in] textColors
+		 * @parblock
+		 * The available text colors.
+		 *
+		 * @pre @em textColors cannot be empty.
+		 * @endparblock
+		 * @param[in] outline The outline parameters to use for the text, or NO_OUTLINE.
+		 * @param[in] textbox The textbox to frame the text around.
+		 **************************************************************************************************************/
+		void addGlyphCachedFormatted(int layer, std::string_view text, tr::TTFont& font, int fontSize,
+									 std::span<tr::RGBA8> textColors, TextOutline outline, const Textbox& textbox);
+
+		/**************************************************************************************************************
+		 * Removes all glyphs from the glyph cache.
+		 *
+		 * Cached glyphs are identified by the address of their font, so this must be called when a font that was used
+		 * for glyph-cached text is destroyed.
+		 **************************************************************************************************************/
+		void clearGlyphCache() noexcept;
+
+		/**************************************************************************************************************
+		 * Sets the number of frames a string stays cached for without being created again.
+		 *
+		 * @param[in] frames The number of frames, 0 evicts every string on every new frame.
+		 **************************************************************************************************************/
+		void setStringCacheLifetime(unsigned int frames) noexcept;
+
+		/**************************************************************************************************************
+		 * Evicts all strings from the string cache.
+		 *
+		 * Cached strings are identified by the address of their font, so this must be called when a font that was used
+		 * for dynamic text is destroyed.
+		 *
+		 * @warning This function should only be called after all previously outputted text was rendered!
+		 **************************************************************************************************************/
+		void clearStringCache() noexcept;
+
+		/**************************************************************************************************************
+		 * Prepares the manager for a new frame, evicting strings that weren't created for longer than the string cache
+		 * lifetime.
+		 *
+		 * The space of evicted strings is returned to the atlas and reused by strings cached later, so strings still in
+		 * use are never rerendered because of evictions.
 		 *
 		 * @warning This function should only be called after all previously outputted text was rendered!
 		 **************************************************************************************************************/
 		void newFrame() noexcept;
 
 	  private:
-		DynAtlas2D _atlas;
-		glm::uvec2 _dpi;
+		// The parameters a glyph is rasterized with.
+		struct GlyphKey {
+			const tr::TTFont* font;
+			int               fontSize;
+			glm::uvec2        dpi;
+			std::uint32_t     style;
+			std::uint32_t     codepoint;
+			int               outlineThickness;
+
+			bool operator==(const GlyphKey&) const = default;
+		};
+
+		struct GlyphKeyHash {
+			std::size_t operator()(const GlyphKey& key) const noexcept;
+		};
+
+		// A glyph in the glyph cache, in pixels. Fills and outlines are rasterized in white and tinted.
+		struct CachedGlyph {
+			// The name of the fill of the glyph in the glyph atlas, or an empty string if the glyph isn't drawn.
+			std::string name;
+			glm::vec2   size;
+			// The name of the outline of the glyph in the glyph atlas, or an empty string if it has no outline.
+			std::string outlineName;
+			glm::vec2   outlineSize;
+			float       advance;
+			float       lineSkip;
+		};
+
+		// A string bitmap kept in the atlas across frames.
+		struct CachedString {
+			std::string name;
+			std::size_t lastUsedFrame;
+		};
+
+		// A glyph of glyph-cached text being laid out.
+		struct LayoutGlyph {
+			const CachedGlyph* glyph;
+			std::uint32_t      codepoint;
+			tr::RGBA8          tint;
+		};
+
+		// A line of glyph-cached text being laid out, referencing a range of glyphs.
+		struct LayoutLine {
+			std::size_t begin;
+			std::size_t end;
+			float       width;
+		};
+
+		DynAtlas2D                                              _atlas;
+		glm::uvec2                                              _dpi;
+		// Cached strings keyed by the parameters and text they were rendered with.
+		std::unordered_map<std::string, CachedString>           _strings;
+		// Scratch key storage, reused to avoid allocating on every lookup.
+		std::string                                             _stringKey;
+		std::size_t                                             _frame;
+		std::size_t                                             _nextStringName;
+		unsigned int                                            _stringCacheLifetime;
+		DynAtlas2D                                              _glyphAtlas;
+		std::unordered_map<GlyphKey, CachedGlyph, GlyphKeyHash> _glyphs;
+		// Whether glyph-cached text was added since the last new frame, after which the glyph atlas can't grow.
+		bool                                                    _glyphTextAdded;
+		// Layout storage reused by the glyph-cached text functions.
+		std::vector<LayoutGlyph>                                _layoutGlyphs;
+		std::vector<LayoutLine>                                 _layoutLines;
+		std::vector<Renderer2D::TextureQuad>                    _layoutQuads;
 
 		Renderer2D::TextureQuad createMesh(const std::string& name, const Textbox& textbox);
+
+		// Starts a string cache key with the parameters shared by all strings.
+		void startStringKey(char kind, const tr::TTFont& font, int fontSize, TextOutline outline,
+							const Textbox& textbox);
+		// Appends the raw bytes of a value to the string cache key.
+		template <class T> void appendStringKey(const T& value);
+		// Looks up the string cache key, marking the string as used this frame. Returns nullptr on a miss.
+		const std::string* findCachedString() noexcept;
+		// Adds a bitmap to the atlas and caches it under the string cache key.
+		const std::string& cacheString(const tr::SubBitmap& bitmap);
+
+		// Gets a glyph from the glyph cache, rasterizing it on a miss.
+		const CachedGlyph& cachedGlyph(std::uint32_t codepoint, std::string_view character, tr::TTFont& font,
+									   int fontSize, tr::TTFont::Style style, int outlineThickness);
+		// Adds a glyph bitmap to the glyph atlas under a new name.
+		std::string addGlyphBitmap(const tr::Bitmap& bitmap);
+		// Appends the glyphs of single-style text to the layout.
+		void appendLayoutGlyphs(std::string_view text, tr::TTFont& font, int fontSize, tr::TTFont::Style style,
+								tr::RGBA8 textColor, int outlineThickness);
+		// Breaks the layout into lines and adds it to a 2D renderer layer.
+		void addLayout(int layer, float lineSkip, TextOutline outline, const Textbox& textbox);
 	};
 
 	/******************************************************************************************************************
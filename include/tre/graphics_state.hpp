@@ -0,0 +1,194 @@
+#pragma once
+#include <tr/tr.hpp>
+
+namespace tre {
+	/** @defgroup graphics_state Graphics State
+	 *  Shared graphics state tracking.
+	 *
+	 *  @{
+	 */
+
+	/******************************************************************************************************************
+	 * Graphics state cache shared by all tre renderers.
+	 *
+	 * Every tre renderer sets graphics state through the cache returned by graphicsState(), which skips calls that
+	 * wouldn't change the current state. Custom renderers should go through it as well, both to benefit from it and to
+	 * keep it accurate.
+	 *
+	 * Objects are identified by their address, so invalidate() must be called when an object that may be in use by the
+	 * cache is destroyed or replaced in place, as well as after issuing graphics calls that bypass the cache. tre
+	 * objects do this themselves.
+	 ******************************************************************************************************************/
+	class GraphicsStateCache {
+	  public:
+		/**************************************************************************************************************
+		 * Graphics call counters.
+		 **************************************************************************************************************/
+		struct Counters {
+			/**********************************************************************************************************
+			 * The number of state changes that were issued.
+			 **********************************************************************************************************/
+			std::size_t issued{0};
+
+			/**********************************************************************************************************
+			 * The number of state changes that were skipped because they wouldn't change the current state.
+			 **********************************************************************************************************/
+			std::size_t skipped{0};
+		};
+
+		/**************************************************************************************************************
+		 * Sets the active framebuffer.
+		 *
+		 * @param[in] framebuffer The framebuffer to draw to.
+		 **************************************************************************************************************/
+		void setFramebuffer(tr::BasicFramebuffer& framebuffer) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets the viewport.
+		 *
+		 * @param[in] viewport The viewport rectangle.
+		 **************************************************************************************************************/
+		void setViewport(const tr::RectI2& viewport) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets the depth range.
+		 *
+		 * @param[in] min The minimum depth value.
+		 * @param[in] max The maximum depth value.
+		 **************************************************************************************************************/
+		void setDepthRange(double min, double max) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets whether the scissor test is used.
+		 *
+		 * @param[in] use Whether to use the scissor test.
+		 **************************************************************************************************************/
+		void useScissorTest(bool use) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets the scissor box.
+		 *
+		 * @param[in] box The scissor box in framebuffer coordinates.
+		 **************************************************************************************************************/
+		void setScissorBox(const tr::RectI2& box) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets whether face culling is used.
+		 *
+		 * @param[in] use Whether to use face culling.
+		 **************************************************************************************************************/
+		void useFaceCulling(bool use) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets whether the depth test is used.
+		 *
+		 * @param[in] use Whether to use the depth test.
+		 **************************************************************************************************************/
+		void useDepthTest(bool use) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets whether the stencil test is used.
+		 *
+		 * @param[in] use Whether to use the stencil test.
+		 **************************************************************************************************************/
+		void useStencilTest(bool use) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets whether blending is used.
+		 *
+		 * @param[in] use Whether to use blending.
+		 **************************************************************************************************************/
+		void useBlending(bool use) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets the blending mode.
+		 *
+		 * @param[in] blendMode The blending mode to use.
+		 **************************************************************************************************************/
+		void setBlendingMode(const tr::BlendMode& blendMode) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets the active shader pipeline.
+		 *
+		 * @param[in] pipeline The shader pipeline to use.
+		 **************************************************************************************************************/
+		void setShaderPipeline(const tr::OwningShaderPipeline& pipeline) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets the active vertex format.
+		 *
+		 * @param[in] format The vertex format to use.
+		 **************************************************************************************************************/
+		void setVertexFormat(const tr::VertexFormat& format) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets the texture bound to a texture unit.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] unit The texture unit to bind the texture to.
+		 * @param[in] texture The texture to bind.
+		 **************************************************************************************************************/
+		void setTexture(tr::TextureUnit& unit, const tr::Texture2D& texture);
+
+		/**************************************************************************************************************
+		 * Sets the sampler bound to a texture unit.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] unit The texture unit to bind the sampler to.
+		 * @param[in] sampler The sampler to bind.
+		 **************************************************************************************************************/
+		void setSampler(tr::TextureUnit& unit, const tr::Sampler& sampler);
+
+		/**************************************************************************************************************
+		 * Forgets all cached state, so that the next call of every setter is issued.
+		 **************************************************************************************************************/
+		void invalidate() noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the counters of issued and skipped state changes.
+		 *
+		 * @return The counters of issued and skipped state changes since the last reset.
+		 **************************************************************************************************************/
+		const Counters& counters() const noexcept;
+
+		/**************************************************************************************************************
+		 * Resets the counters of issued and skipped state changes.
+		 **************************************************************************************************************/
+		void resetCounters() noexcept;
+
+	  private:
+		struct TextureUnitState {
+			const tr::Texture2D* texture{nullptr};
+			const tr::Sampler*   sampler{nullptr};
+		};
+
+		// Empty optionals represent unknown state.
+		std::optional<tr::BasicFramebuffer*>                         _framebuffer;
+		std::optional<tr::RectI2>                                    _viewport;
+		std::optional<std::pair<double, double>>                     _depthRange;
+		std::optional<bool>                                          _scissorTest;
+		std::optional<tr::RectI2>                                    _scissorBox;
+		std::optional<bool>                                          _faceCulling;
+		std::optional<bool>                                          _depthTest;
+		std::optional<bool>                                          _stencilTest;
+		std::optional<bool>                                          _blending;
+		std::optional<tr::BlendMode>                                 _blendMode;
+		std::optional<const tr::OwningShaderPipeline*>               _pipeline;
+		std::optional<const tr::VertexFormat*>                       _vertexFormat;
+		std::unordered_map<const tr::TextureUnit*, TextureUnitState> _textureUnits;
+		Counters                                                     _counters;
+
+		template <class T, class Fn> void set(std::optional<T>& current, const T& value, Fn issue) noexcept;
+	};
+
+	/******************************************************************************************************************
+	 * Gets a reference to the graphics state cache shared by all tre renderers.
+	 *
+	 * @return A reference to the graphics state cache.
+	 ******************************************************************************************************************/
+	GraphicsStateCache& graphicsState() noexcept;
+
+	/// @}
+} // namespace tre
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace tre {
+	/** @defgroup null_graphics Null Graphics
+	 *  Null graphics backend functionality.
+	 *
+	 *  Renderers constructed with the null graphics backend don't create any graphics objects or issue any graphics
+	 *  calls, instead recording the calls they would have made. This allows for benchmarking and testing of their
+	 *  CPU-side work without a graphics context. Managers constructed with it likewise don't create their textures.
+	 *  @{
+	 */
+
+	/******************************************************************************************************************
+	 * Tag type for constructing renderers with the null graphics backend.
+	 ******************************************************************************************************************/
+	struct NullGraphics {
+		explicit NullGraphics() = default;
+	};
+
+	/******************************************************************************************************************
+	 * Tag constant for constructing renderers with the null graphics backend.
+	 ******************************************************************************************************************/
+	inline constexpr NullGraphics NULL_GRAPHICS{};
+
+	/******************************************************************************************************************
+	 * A graphics call recorded by the null graphics backend.
+	 ******************************************************************************************************************/
+	struct GraphicsCall {
+		/**************************************************************************************************************
+		 * Graphics call types.
+		 **************************************************************************************************************/
+		enum class Type : std::uint8_t {
+			/**********************************************************************************************************
+			 * Vertex data was uploaded to a buffer. The size is the number of uploaded bytes.
+			 **********************************************************************************************************/
+			UPLOAD_VERTICES,
+
+			/**********************************************************************************************************
+			 * Index data was uploaded to a buffer. The size is the number of uploaded bytes.
+			 **********************************************************************************************************/
+			UPLOAD_INDICES,
+
+			/**********************************************************************************************************
+			 * The used texture was changed.
+			 **********************************************************************************************************/
+			SET_TEXTURE,
+
+			/**********************************************************************************************************
+			 * The used sampler was changed.
+			 **********************************************************************************************************/
+			SET_SAMPLER,
+
+			/**********************************************************************************************************
+			 * The transformation matrix was changed.
+			 **********************************************************************************************************/
+			SET_TRANSFORM,
+
+			/**********************************************************************************************************
+			 * The blending mode was changed.
+			 **********************************************************************************************************/
+			SET_BLEND_MODE,
+
+			/**********************************************************************************************************
+			 * A vertex buffer was bound. The offset is the byte offset the buffer was bound at.
+			 **********************************************************************************************************/
+			BIND_VERTEX_BUFFER,
+
+			/**********************************************************************************************************
+			 * An index buffer was bound.
+			 **********************************************************************************************************/
+			BIND_INDEX_BUFFER,
+
+			/**********************************************************************************************************
+			 * An indexed draw was issued. The offset is the offset to the first index and the size is the number of
+			 * indices.
+			 **********************************************************************************************************/
+			DRAW_INDEXED
+		};
+
+		/**************************************************************************************************************
+		 * The type of the call.
+		 **************************************************************************************************************/
+		Type type;
+
+		/**************************************************************************************************************
+		 * The offset argument of the call, if any.
+		 **************************************************************************************************************/
+		std::size_t offset{0};
+
+		/**************************************************************************************************************
+		 * The size argument of the call, if any.
+		 **************************************************************************************************************/
+		std::size_t size{0};
+
+		/**************************************************************************************************************
+		 * Equality comparison operator.
+		 **************************************************************************************************************/
+		friend bool operator==(const GraphicsCall&, const GraphicsCall&) = default;
+	};
+
+	/// @}
+} // namespace tre
\ No newline at end of file
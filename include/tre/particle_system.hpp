@@ -0,0 +1,323 @@
+#pragma once
+#include "renderer_2d.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace tre {
+	/** @defgroup particles Particles
+	 *  2D particle system functionality.
+	 *
+	 *  @{
+	 */
+
+	/******************************************************************************************************************
+	 * Instanced 2D particle system.
+	 *
+	 * Particles are spawned by emitters and stored in structure-of-arrays form, so that they can be integrated in
+	 * vectorized loops. All particles of a system are drawn in a single instanced draw using the rendering
+	 * configuration (texture, sampler, transformation matrix, blending mode) of a Renderer2D layer.
+	 *
+	 * update() doesn't interact with the graphics context, so it may be called on a worker thread, as long as it
+	 * doesn't overlap with any other call on the same particle system.
+	 *
+	 * @note An instance of tr::Window must be created before ParticleSystem can be instantiated.
+	 ******************************************************************************************************************/
+	class ParticleSystem {
+	  public:
+		/**************************************************************************************************************
+		 * Particle emitter parameters.
+		 **************************************************************************************************************/
+		struct Emitter {
+			/**********************************************************************************************************
+			 * The position of the center of the emitter.
+			 **********************************************************************************************************/
+			glm::vec2 pos;
+
+			/**********************************************************************************************************
+			 * The size of the rectangle around the position particles are spawned in.
+			 **********************************************************************************************************/
+			glm::vec2 size{};
+
+			/**********************************************************************************************************
+			 * The number of particles spawned per second.
+			 **********************************************************************************************************/
+			float rate;
+
+			/**********************************************************************************************************
+			 * The minimum lifetime of a spawned particle.
+			 *
+			 * @pre The minimum lifetime must be greater than 0.
+			 **********************************************************************************************************/
+			tr::SecondsF minLifetime;
+
+			/**********************************************************************************************************
+			 * The maximum lifetime of a spawned particle.
+			 *
+			 * @pre The maximum lifetime cannot be less than the minimum lifetime.
+			 **********************************************************************************************************/
+			tr::SecondsF maxLifetime;
+
+			/**********************************************************************************************************
+			 * The central direction spawned particles move in.
+			 **********************************************************************************************************/
+			tr::AngleF direction;
+
+			/**********************************************************************************************************
+			 * The width of the range of directions around the central direction spawned particles move in.
+			 **********************************************************************************************************/
+			tr::AngleF spread;
+
+			/**********************************************************************************************************
+			 * The minimum initial speed of a spawned particle, in units per second.
+			 **********************************************************************************************************/
+			float minSpeed;
+
+			/**********************************************************************************************************
+			 * The maximum initial speed of a spawned particle, in units per second.
+			 *
+			 * @pre The maximum speed cannot be less than the minimum speed.
+			 **********************************************************************************************************/
+			float maxSpeed;
+
+			/**********************************************************************************************************
+			 * The acceleration applied to the particles, in units per second squared.
+			 **********************************************************************************************************/
+			glm::vec2 acceleration{};
+
+			/**********************************************************************************************************
+			 * The size of a particle at the beginning of its life.
+			 **********************************************************************************************************/
+			float startSize;
+
+			/**********************************************************************************************************
+			 * The size of a particle at the end of its life.
+			 **********************************************************************************************************/
+			float endSize;
+
+			/**********************************************************************************************************
+			 * The color of a particle at the beginning of its life.
+			 **********************************************************************************************************/
+			tr::RGBA8 startColor;
+
+			/**********************************************************************************************************
+			 * The color of a particle at the end of its life.
+			 **********************************************************************************************************/
+			tr::RGBA8 endColor;
+
+			/**********************************************************************************************************
+			 * The UV rectangle of the particle within the layer texture. Ignored when drawn to a color-only layer.
+			 **********************************************************************************************************/
+			tr::RectF2 uv{{0, 0}, {1, 1}};
+		};
+
+		/**************************************************************************************************************
+		 * Constructs a particle system.
+		 *
+		 * @exception tr::GLBufferBadAlloc If an internal allocation fails.
+		 **************************************************************************************************************/
+		ParticleSystem();
+
+		/**************************************************************************************************************
+		 * Move-constructs a particle system.
+		 *
+		 * @param[in] r The particle system to move from. @em r will be left in a moved-from state that shouldn't be used.
+		 **************************************************************************************************************/
+		ParticleSystem(ParticleSystem&& r) noexcept;
+
+		/**************************************************************************************************************
+		 * Destroys the particle system.
+		 **************************************************************************************************************/
+		~ParticleSystem() noexcept;
+
+		/**************************************************************************************************************
+		 * Adds an emitter to the system.
+		 *
+		 * @par Exception Safety
+		 *
+		 * Strong exception guarantee.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] id
+		 * @parblock
+		 * The ID of the emitter.
+		 *
+		 * @pre An emitter with this ID cannot exist already.
+		 * @endparblock
+		 * @param[in] emitter
+		 * @parblock
+		 * The parameters of the emitter.
+		 *
+		 * @pre The lifetime and speed ranges of the emitter must be valid, see Emitter.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void addEmitter(int id, const Emitter& emitter);
+
+		/**************************************************************************************************************
+		 * Gets the parameters of an emitter.
+		 *
+		 * Changes to the parameters only affect particles spawned afterwards, except for the acceleration, sizes,
+		 * colors and UV rectangle, which are shared by all of the emitter's particles. The lifetime and speed ranges
+		 * must be kept valid while changing them.
+		 *
+		 * @param[in] id
+		 * @parblock
+		 * The ID of the emitter.
+		 *
+		 * @pre The system must have an emitter with ID @em id.
+		 * @endparblock
+		 *
+		 * @return A reference to the parameters of the emitter.
+		 **************************************************************************************************************/
+		Emitter& emitter(int id) noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the parameters of an emitter.
+		 *
+		 * @param[in] id
+		 * @parblock
+		 * The ID of the emitter.
+		 *
+		 * @pre The system must have an emitter with ID @em id.
+		 * @endparblock
+		 *
+		 * @return An immutable reference to the parameters of the emitter.
+		 **************************************************************************************************************/
+		const Emitter& emitter(int id) const noexcept;
+
+		/**************************************************************************************************************
+		 * Removes an emitter and all of its particles from the system.
+		 *
+		 * @param[in] id The ID of the emitter. If no such emitter exists, nothing happens.
+		 **************************************************************************************************************/
+		void removeEmitter(int id) noexcept;
+
+		/**************************************************************************************************************
+		 * Immediately spawns a number of particles from an emitter.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] id
+		 * @parblock
+		 * The ID of the emitter.
+		 *
+		 * @pre The system must have an emitter with ID @em id.
+		 * @endparblock
+		 * @param[in] count The number of particles to spawn.
+		 **************************************************************************************************************/
+		void burst(int id, std::size_t count);
+
+		/**************************************************************************************************************
+		 * Removes all particles from the system, leaving the emitters in place.
+		 **************************************************************************************************************/
+		void clear() noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the number of live particles in the system.
+		 *
+		 * @return The number of live particles in the system.
+		 **************************************************************************************************************/
+		std::size_t particleCount() const noexcept;
+
+		/**************************************************************************************************************
+		 * Advances the simulation.
+		 *
+		 * Emitters spawn new particles, particles are integrated and expired particles are removed. The particle data
+		 * to be drawn is also generated here, so that draw() only has to upload it.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 * @exception std::system_error If a worker thread couldn't be started. Worker threads are kept between updates,
+		 *                              so they are only started when more threads are requested than ever before.
+		 *
+		 * @param[in] delta The time since the last update.
+		 * @param[in] threads
+		 * @parblock
+		 * The number of threads to split the integration of the particles across, including the calling thread.
+		 *
+		 * @pre @em threads must be greater than 0.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void update(tr::SecondsF delta, unsigned int threads = 1);
+
+		/**************************************************************************************************************
+		 * Draws the particles as of the last update.
+		 *
+		 * @exception tr::GLBufferBadAlloc If an internal allocation fails.
+		 *
+		 * @param[in] view The view to draw to.
+		 * @param[in] layer
+		 * @parblock
+		 * The Renderer2D layer whose texture, sampler, transformation matrix and blending mode are used.
+		 *
+		 * @pre The 2D renderer must be instantiated and have a layer with priority @em layer.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void draw(const RenderView& view, int layer);
+
+	  private:
+		// Particles are stored per emitter, so that emitter parameters are uniform within the integration loops.
+		struct Particles {
+			std::vector<float> posX;
+			std::vector<float> posY;
+			std::vector<float> velX;
+			std::vector<float> velY;
+			// The fraction of the particle's lifetime that has passed.
+			std::vector<float> life;
+			// The reciprocal of the particle's lifetime in seconds.
+			std::vector<float> lifeRate;
+		};
+		struct EmitterState {
+			Emitter   emitter;
+			Particles particles;
+			// Fractional particles left over from previous updates.
+			float spawnAccumulator;
+		};
+		struct ShaderParticle {
+			glm::vec2 pos;
+			float     size;
+			tr::RGBA8 color;
+			glm::vec2 uvTL;
+			glm::vec2 uvSize;
+		};
+
+		// Worker threads kept across updates to run the ranges of forEachRange().
+		class WorkerPool {
+		  public:
+			// Starts workers until there are at least a given number of them.
+			void reserve(std::size_t workers);
+			// Queues a batch of jobs, none of which are queued if an exception is thrown.
+			void run(std::span<std::function<void()>> jobs);
+
+		  private:
+			std::mutex                        _mutex;
+			std::condition_variable_any       _jobQueued;
+			std::deque<std::function<void()>> _jobs;
+			// Declared last so that the workers are stopped and joined first.
+			std::vector<std::jthread> _workers;
+
+			void work(std::stop_token stop);
+		};
+
+		tr::OwningShaderPipeline _shaderPipeline;
+		tr::ShaderBuffer         _shaderParticleBuffer;
+		tr::TextureUnit          _textureUnit;
+		tr::VertexFormat         _vertexFormat;
+		tr::VertexBuffer         _vertexBuffer;
+
+		std::map<int, EmitterState> _emitters;
+		std::minstd_rand            _rng;
+		std::vector<ShaderParticle> _shaderParticles;
+		// Held by pointer to keep the system movable.
+		std::unique_ptr<WorkerPool> _workerPool;
+
+		void spawn(EmitterState& state, std::size_t count);
+		template <class Fn> void forEachRange(unsigned int threads, Fn fn);
+		void setupContext(const tr::BlendMode& blendMode) noexcept;
+	};
+
+	/// @}
+} // namespace tre
\ No newline at end of file
@@ -50,15 +50,40 @@ namespace tre {
 		 *************************************************************************************************************/
 		friend bool operator==(const RenderView& l, const RenderView& r) noexcept;
 
+		/**************************************************************************************************************
+		 * Gets the viewport of the view.
+		 *
+		 * @return The viewport of the view inside its framebuffer.
+		 **************************************************************************************************************/
+		const tr::RectI2& viewport() const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the framebuffer of the view.
+		 *
+		 * @return A reference to the framebuffer the view is over.
+		 **************************************************************************************************************/
+		tr::BasicFramebuffer& framebuffer() const noexcept;
+
 		/*************************************************************************************************************
 		 * Sets up the graphics context to use the render view.
 		 *
 		 * This method is primarily intended for use in custom renderers.
 		 *
-		 * @note Consecutive calls to use() by the same render view are optimized to minimise internal state switching.
+		 * @note State is set through the shared graphics state cache, so redundant state changes are skipped.
 		 **************************************************************************************************************/
 		void use() const noexcept;
 
+		/*************************************************************************************************************
+		 * Sets up the graphics context to use the render view, restricting drawing to a region of the view.
+		 *
+		 * This method is primarily intended for use in custom renderers.
+		 *
+		 * @note State is set through the shared graphics state cache, so redundant state changes are skipped.
+		 *
+		 * @param scissorBox The region of the view drawing is restricted to, relative to the viewport.
+		 **************************************************************************************************************/
+		void use(const tr::RectI2& scissorBox) const noexcept;
+
 	  private:
 		std::reference_wrapper<tr::BasicFramebuffer> _framebuffer;
 		tr::RectI2                                   _viewport;
@@ -1,4 +1,5 @@
 #pragma once
+#include "null_graphics.hpp"
 #include "render_view.hpp"
 #include <map>
 
@@ -35,6 +36,21 @@ namespace tre {
 		 **************************************************************************************************************/
 		Renderer2D();
 
+		/**************************************************************************************************************
+		 * Creates the 2D renderer with the null graphics backend and enables the ability to use the tre::renderer2D()
+		 * getter.
+		 *
+		 * The renderer doesn't create any graphics objects or issue any graphics calls, recording the calls it would
+		 * have made instead, so it can be used without a tr::Window. Frames must be drawn with
+		 * drawPrepared(NullGraphics, const glm::mat4&), and layer caching, dirty-rectangle tracking and GPU timing
+		 * are ignored.
+		 *
+		 * @note Only one instance of Renderer2D can exist at any one time.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 **************************************************************************************************************/
+		explicit Renderer2D(NullGraphics);
+
 		/**************************************************************************************************************
 		 * Move-constructs a 2D renderer.
 		 *
@@ -165,10 +181,165 @@ namespace tre {
 		 *
 		 * @pre The renderer must have a layer with priority @em layer.
 		 * @endparblock
-		 * @param[in] blendMode The blending mode to use for textured primitives on this layer.
+		 * @param[in] blendMode
+		 * @parblock
+		 * The blending mode to use for textured primitives on this layer.
+		 *
+		 * @pre If @em layer is cached, @em blendMode must be cacheable (see cacheBlendMode()).
+		 * @endparblock
 		 **************************************************************************************************************/
 		void setLayerBlendMode(int layer, const tr::BlendMode& blendMode) noexcept;
 
+		/**************************************************************************************************************
+		 * Gets the texture used by textured primitives on a layer.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to get the texture of.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 * @endparblock
+		 *
+		 * @return A pointer to the texture of the layer, or nullptr if the layer is color-only.
+		 **************************************************************************************************************/
+		const tr::Texture2D* layerTexture(int layer) const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the sampler used by textured primitives on a layer.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to get the sampler of.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 * @endparblock
+		 *
+		 * @return A pointer to the sampler of the layer, or nullptr if the layer is color-only.
+		 **************************************************************************************************************/
+		const tr::Sampler* layerSampler(int layer) const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the transformation matrix used by primitives on a layer.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to get the transformation matrix of.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 * @endparblock
+		 *
+		 * @return The transformation matrix of the layer.
+		 **************************************************************************************************************/
+		const glm::mat4& layerTransform(int layer) const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the blending mode used by primitives on a layer.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to get the blending mode of.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 * @endparblock
+		 *
+		 * @return The blending mode of the layer.
+		 **************************************************************************************************************/
+		const tr::BlendMode& layerBlendMode(int layer) const noexcept;
+
+		/**************************************************************************************************************
+		 * Sets whether a layer is retained.
+		 *
+		 * Primitives on a retained layer aren't cleared after being drawn. Instead, they are uploaded once to a buffer
+		 * dedicated to the layer and redrawn every frame until the layer is invalidated, with only the rendering
+		 * configuration of the layer (texture, sampler, transformation matrix, blending mode) being updated per frame.
+		 * Adding primitives to a retained layer appends them to its geometry, which is reuploaded on the next draw.
+		 *
+		 * @note Turning off retention leaves any primitives on the layer in place to be drawn and cleared normally.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to set the retention of.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 * @endparblock
+		 * @param[in] retained Whether the layer should be retained.
+		 **************************************************************************************************************/
+		void setLayerRetained(int layer, bool retained);
+
+		/**************************************************************************************************************
+		 * Clears the geometry of a retained layer.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to invalidate.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 *
+		 * @pre @em layer must be a retained layer.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void invalidateLayer(int layer) noexcept;
+
+		/**************************************************************************************************************
+		 * Sets whether a layer is cached.
+		 *
+		 * A cached layer is rendered into an offscreen texture the first time it is drawn, after which the texture is
+		 * drawn in its place as a single quad. The cache is rerendered only when the layer is marked dirty, its
+		 * geometry changes, or it is drawn to a view of a different size or with a different transformation matrix.
+		 * This is useful for layers with many primitives that rarely change.
+		 *
+		 * Cached layers are always retained, so setting a layer to be cached turns on its retention as well.
+		 *
+		 * The layer is rendered into the cache with cacheBlendMode(), leaving the cache premultiplied, and the cache is
+		 * composited with CACHE_COMPOSITE_BLENDING, so translucent primitives look the same as when drawn uncached.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to set the caching of.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 *
+		 * @pre If @em cached is true, the blending mode of @em layer must be cacheable (see cacheBlendMode()).
+		 * @endparblock
+		 * @param[in] cached Whether the layer should be cached.
+		 **************************************************************************************************************/
+		void setLayerCached(int layer, bool cached);
+
+		/**************************************************************************************************************
+		 * The blending mode caches of cached layers are composited with.
+		 **************************************************************************************************************/
+		static constexpr tr::BlendMode CACHE_COMPOSITE_BLENDING{
+			tr::BlendMultiplier::ONE, tr::BlendFunction::ADD, tr::BlendMultiplier::ONE_MINUS_SRC_ALPHA,
+			tr::BlendMultiplier::ONE, tr::BlendFunction::ADD, tr::BlendMultiplier::ONE_MINUS_SRC_ALPHA};
+
+		/**************************************************************************************************************
+		 * Gets the blending mode a cached layer is rendered into its cache with.
+		 *
+		 * Only blending modes that add the source color, weighted by its alpha (straight alpha blending) or as is
+		 * (premultiplied alpha blending), to the destination weighted by one minus the source alpha can be cached.
+		 * The alpha channel of a cached layer is always composited as with premultiplied alpha blending.
+		 *
+		 * @param[in] blendMode The blending mode of the layer.
+		 *
+		 * @return The blending mode that leaves the cache premultiplied, or std::nullopt if @em blendMode can't be
+		 *         cached.
+		 **************************************************************************************************************/
+		static std::optional<tr::BlendMode> cacheBlendMode(const tr::BlendMode& blendMode) noexcept;
+
+		/**************************************************************************************************************
+		 * Marks the cache of a cached layer as dirty, causing it to be rerendered on the next draw.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to mark as dirty.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 *
+		 * @pre @em layer must be a cached layer.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void markLayerDirty(int layer) noexcept;
+
 		/**************************************************************************************************************
 		 * Removes a layer from the renderer.
 		 *
@@ -250,7 +421,7 @@ namespace tre {
 		 * @parblock
 		 * The vertex fan to draw according to layer parameters.
 		 *
-		 * @pre @em fan must contain 3 or more vertices.
+		 * @pre @em fan must contain between 3 and 65536 vertices.
 		 * @endparblock
 		 **************************************************************************************************************/
 		void addColorFan(int layer, const ColorFan& fan);
@@ -281,7 +452,7 @@ namespace tre {
 		 * @parblock
 		 * The vertex fan to draw according to layer parameters.
 		 *
-		 * @pre @em fan must contain 3 or more vertices.
+		 * @pre @em fan must contain between 3 and 65536 vertices.
 		 * @endparblock
 		 **************************************************************************************************************/
 		void addTextureFan(int layer, const TextureFan& fan);
@@ -307,7 +478,7 @@ namespace tre {
 		 * @parblock
 		 * The vertex fan to draw according to layer parameters. The contents of @em fan will be moved.
 		 *
-		 * @pre @em fan must contain 3 or more vertices.
+		 * @pre @em fan must contain between 3 and 65536 vertices.
 		 * @endparblock
 		 **************************************************************************************************************/
 		void addTextureFan(int layer, TextureFan&& fan);
@@ -438,9 +609,301 @@ namespace tre {
 		 **************************************************************************************************************/
 		void addTextureMesh(int layer, std::vector<tr::TintVtx2>&& vertices, std::vector<std::uint16_t>&& indices);
 
+		/**************************************************************************************************************
+		 * Writable storage of a textured mesh added with allocateTextureMesh().
+		 **************************************************************************************************************/
+		struct TextureMeshSpans {
+			/**********************************************************************************************************
+			 * The vertices of the mesh.
+			 **********************************************************************************************************/
+			std::span<tr::TintVtx2> vertices;
+
+			/**********************************************************************************************************
+			 * The indices of the mesh.
+			 **********************************************************************************************************/
+			std::span<std::uint16_t> indices;
+		};
+
+		/**************************************************************************************************************
+		 * Adds a textured mesh to be rendered, whose contents are written in place by the caller.
+		 *
+		 * This avoids building the mesh in separate storage and copying it into the renderer. The storage is taken from
+		 * a pool owned by the layer and is left uninitialized.
+		 *
+		 * @par Exception Safety
+		 *
+		 * Strong exception guarantee.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to draw the mesh on.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 *
+		 * @pre @em layer must be a full layer, i.e. have a texture and sampler defined for it.
+		 * @endparblock
+		 * @param[in] vertices
+		 * @parblock
+		 * The number of vertices of the mesh.
+		 *
+		 * @pre @em vertices must be between 3 and 65536.
+		 * @endparblock
+		 * @param[in] indices The number of indices of the mesh.
+		 *
+		 * @return Spans over the vertices and indices of the mesh, which must be fully written before the layer is
+		 *         drawn. The contents of the indices must span from [0, vertices). The spans stay valid until another
+		 *         primitive is added to the layer or the primitives of the layer are cleared.
+		 **************************************************************************************************************/
+		TextureMeshSpans allocateTextureMesh(int layer, std::size_t vertices, std::size_t indices);
+
+		/**************************************************************************************************************
+		 * Sets the size of the view shapes will be drawn to.
+		 *
+		 * The number of segments used to approximate curved shapes is chosen based on their size in this view. Shapes
+		 * added before the size is changed are unaffected. The size defaults to 1920x1080.
+		 *
+		 * @param[in] size The size of the target view in pixels.
+		 **************************************************************************************************************/
+		void setTargetViewSize(glm::ivec2 size) noexcept;
+
+		/**************************************************************************************************************
+		 * Adds an untextured filled circle to be rendered.
+		 *
+		 * The number of segments used to approximate the circle is chosen based on its size in the target view.
+		 *
+		 * @par Exception Safety
+		 *
+		 * Strong exception guarantee.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to draw the circle on.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 * @endparblock
+		 * @param[in] center The center of the circle.
+		 * @param[in] radius The radius of the circle.
+		 * @param[in] color The color of the circle.
+		 **************************************************************************************************************/
+		void addColorCircle(int layer, glm::vec2 center, float radius, tr::RGBA8 color);
+
+		/**************************************************************************************************************
+		 * Adds an untextured circular arc outline to be rendered.
+		 *
+		 * The number of segments used to approximate the arc is chosen based on its size in the target view.
+		 *
+		 * @par Exception Safety
+		 *
+		 * Strong exception guarantee.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to draw the arc on.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 * @endparblock
+		 * @param[in] center The center of the arc.
+		 * @param[in] radius The radius of the middle of the arc outline.
+		 * @param[in] start The starting angle of the arc.
+		 * @param[in] size The angular size of the arc.
+		 * @param[in] thickness The thickness of the arc outline.
+		 * @param[in] color The color of the arc.
+		 **************************************************************************************************************/
+		void addColorArc(int layer, glm::vec2 center, float radius, tr::AngleF start, tr::AngleF size, float thickness,
+						 tr::RGBA8 color);
+
+		/**************************************************************************************************************
+		 * Adds an untextured filled rounded rectangle to be rendered.
+		 *
+		 * The number of segments used to approximate the corners is chosen based on their size in the target view.
+		 *
+		 * @par Exception Safety
+		 *
+		 * Strong exception guarantee.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to draw the rectangle on.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 * @endparblock
+		 * @param[in] rect The rectangle.
+		 * @param[in] radius
+		 * @parblock
+		 * The radius of the corners of the rectangle.
+		 *
+		 * @pre @em radius must not be larger than half of the smaller dimension of @em rect.
+		 * @endparblock
+		 * @param[in] color The color of the rectangle.
+		 **************************************************************************************************************/
+		void addColorRoundedRect(int layer, const tr::RectF2& rect, float radius, tr::RGBA8 color);
+
+		/**************************************************************************************************************
+		 * Adds an untextured thick polyline to be rendered.
+		 *
+		 * Consecutive segments are joined with mitered joins, the length of which is limited for sharp angles.
+		 *
+		 * @par Exception Safety
+		 *
+		 * Strong exception guarantee.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] layer
+		 * @parblock
+		 * The layer to draw the polyline on.
+		 *
+		 * @pre The renderer must have a layer with priority @em layer.
+		 * @endparblock
+		 * @param[in] points
+		 * @parblock
+		 * The points of the polyline.
+		 *
+		 * @pre @em points must contain between 2 and 32768 points.
+		 *
+		 * @pre Consecutive points must not be equal.
+		 * @endparblock
+		 * @param[in] thickness The thickness of the polyline.
+		 * @param[in] color The color of the polyline.
+		 **************************************************************************************************************/
+		void addColorPolyline(int layer, std::span<const glm::vec2> points, float thickness, tr::RGBA8 color);
+
+		/**************************************************************************************************************
+		 * Enables dirty-rectangle tracking.
+		 *
+		 * While tracking is enabled, the renderer compares the primitives of every frame drawn to a view to the ones
+		 * of the frame previously drawn to that view. Each view is tracked separately, so a prepared frame can be
+		 * drawn to several views. A framebuffer with several buffers (like a double-buffered backbuffer) holds the
+		 * frame drawn @em bufferCount frames ago when drawing begins, so the region covered by primitives that changed
+		 * in any of the last @em bufferCount frames is cleared and redrawn. Drawing is skipped entirely only if
+		 * nothing changed in those frames. The first @em bufferCount frames drawn to a view after enabling tracking or
+		 * calling invalidateDirtyRects() are redrawn in full.
+		 *
+		 * Primitives are compared by their position in drawing order, as reordering them can change the result of
+		 * blending. Inserting or removing a primitive therefore marks every later primitive of the frame as changed.
+		 *
+		 * @note The contents of the target views must not be cleared manually, and framebuffers must be swapped in
+		 *       a fixed cycle of @em bufferCount buffers.
+		 *
+		 * @note Changes to the contents of layer textures are not detected, use invalidateDirtyRects() to force a full
+		 *       redraw after modifying them.
+		 *
+		 * @param[in] clearColor The color the changed region is cleared to before redrawing.
+		 * @param[in] bufferCount
+		 * @parblock
+		 * The number of buffers the target views cycle through: 1 for offscreen framebuffers whose contents persist,
+		 * 2 for a double-buffered backbuffer, and so on.
+		 *
+		 * @pre @em bufferCount must be at least 1.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void enableDirtyRectTracking(const glm::vec4& clearColor, std::size_t bufferCount = 2);
+
+		/**************************************************************************************************************
+		 * Disables dirty-rectangle tracking.
+		 **************************************************************************************************************/
+		void disableDirtyRectTracking() noexcept;
+
+		/**************************************************************************************************************
+		 * Forces the frames drawn while dirty-rectangle tracking is enabled to be redrawn in full until every buffer of
+		 * every view holds a tracked frame again.
+		 *
+		 * This also forgets all tracked views, which should be done after destroying a framebuffer that was drawn to.
+		 **************************************************************************************************************/
+		void invalidateDirtyRects() noexcept;
+
+		/**************************************************************************************************************
+		 * Sets whether runs of layers are drawn with multi-draw-indirect calls.
+		 *
+		 * When enabled, consecutive layers that share a texture, sampler and blending mode are drawn with as few
+		 * multi-draw-indirect calls as possible, with every layer's transformation matrix fetched from a storage
+		 * buffer indexed by draw ID. This reduces driver overhead in scenes with many layers that differ only in
+		 * transformation. Cached layers and draws with GPU timing enabled don't use this path.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] enabled Whether multi-draw-indirect submission should be enabled.
+		 **************************************************************************************************************/
+		void setMultiDrawIndirectEnabled(bool enabled);
+
+		/**************************************************************************************************************
+		 * Prepares all layers of priority <= maxLayer for drawing.
+		 *
+		 * The geometry of the layers is uploaded and their rendering configuration is recorded, after which the
+		 * prepared frame can be drawn any number of times with drawPrepared(). Primitives on prepared layers are
+		 * cleared afterwards, except on retained layers. Any previously prepared frame is discarded.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 * @exception tr::GLBufferBadAlloc If an internal allocation fails.
+		 *
+		 * @param[in] maxLayer The maximum prepared layer priority.
+		 **************************************************************************************************************/
+		void prepareUpToLayer(int maxLayer);
+
+		/**************************************************************************************************************
+		 * Prepares all layers for drawing.
+		 *
+		 * Equivalent to prepareUpToLayer(INT_MAX).
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 * @exception tr::GLBufferBadAlloc If an internal allocation fails.
+		 **************************************************************************************************************/
+		void prepare();
+
+		/**************************************************************************************************************
+		 * Draws the prepared frame to a render view.
+		 *
+		 * @pre The renderer must not have been created with the null graphics backend.
+		 *
+		 * @warning The prepared frame is invalidated by removing a prepared layer or by invalidating or turning off
+		 *          the retention of a prepared retained layer.
+		 *
+		 * @param[in] view The target render view.
+		 **************************************************************************************************************/
+		void drawPrepared(const RenderView& view = tr::window().backbuffer());
+
+		/**************************************************************************************************************
+		 * Draws the prepared frame to a render view with an additional view transformation.
+		 *
+		 * @pre The renderer must not have been created with the null graphics backend.
+		 *
+		 * @warning The prepared frame is invalidated by removing a prepared layer or by invalidating or turning off
+		 *          the retention of a prepared retained layer.
+		 *
+		 * @param[in] view The target render view.
+		 * @param[in] viewTransform
+		 * @parblock
+		 * A transformation matrix applied on top of the transformation matrix of every layer.
+		 *
+		 * This can be used to draw the same frame to a minimap or a second viewport.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void drawPrepared(const RenderView& view, const glm::mat4& viewTransform);
+
+		/**************************************************************************************************************
+		 * Draws the prepared frame with the null graphics backend.
+		 *
+		 * @pre The renderer must have been created with the null graphics backend.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] viewTransform A transformation matrix applied on top of the transformation matrix of every layer.
+		 **************************************************************************************************************/
+		void drawPrepared(NullGraphics, const glm::mat4& viewTransform = glm::mat4{1});
+
 		/**************************************************************************************************************
 		 * Draws all layers of priority <= maxLayer to a render view.
 		 *
+		 * Equivalent to prepareUpToLayer(maxLayer) followed by drawPrepared(view).
+		 *
 		 * @exception std::bad_alloc If an internal allocation fails.
 		 * @exception tr::GLBufferBadAlloc If an internal allocation fails.
 		 *
@@ -452,7 +915,7 @@ namespace tre {
 		/**************************************************************************************************************
 		 * Draws all added primitives to a render view.
 		 *
-		 * Equivalent to drawUpToLayer(target, INT_MAX).
+		 * Equivalent to drawUpToLayer(INT_MAX, view).
 		 *
 		 * @exception std::bad_alloc If an internal allocation fails.
 		 * @exception tr::GLBufferBadAlloc If an internal allocation fails.
@@ -461,28 +924,511 @@ namespace tre {
 		 **************************************************************************************************************/
 		void draw(const RenderView& view = tr::window().backbuffer());
 
+		/**************************************************************************************************************
+		 * A captured frame of renderer submissions.
+		 *
+		 * A capture stores the layers of the renderer with their configuration and primitives, and can be saved to
+		 * and loaded from a stream for replaying with replayFrame(). Textures and samplers are stored as indices into
+		 * tables that are supplied when replaying.
+		 *
+		 * @note Captures are stored in native byte order.
+		 **************************************************************************************************************/
+		class FrameCapture;
+
+		/**************************************************************************************************************
+		 * Captures the current contents of all layers of priority <= maxLayer.
+		 *
+		 * This should be called before the frame is prepared, as preparing it clears the primitives of non-retained
+		 * layers.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] maxLayer The maximum captured layer priority.
+		 *
+		 * @return The captured frame.
+		 **************************************************************************************************************/
+		FrameCapture captureFrame(int maxLayer = std::numeric_limits<int>::max()) const;
+
+		/**************************************************************************************************************
+		 * Replays a captured frame.
+		 *
+		 * Captured layers missing from the renderer are added, and the configuration of existing ones is overwritten.
+		 * The captured primitives are then added to the layers, with captured retained layers being invalidated first.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] capture The captured frame.
+		 * @param[in] textures
+		 * @parblock
+		 * The textures to use in place of the captured textures, indexed in the same order.
+		 *
+		 * @pre Unless the renderer uses the null graphics backend, @em textures must contain at least
+		 *      capture.textureCount() elements.
+		 * @endparblock
+		 * @param[in] samplers
+		 * @parblock
+		 * The samplers to use in place of the captured samplers, indexed in the same order.
+		 *
+		 * @pre Unless the renderer uses the null graphics backend, @em samplers must contain at least
+		 *      capture.samplerCount() elements.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void replayFrame(const FrameCapture& capture, std::span<const tr::Texture2D* const> textures = {},
+						 std::span<const tr::Sampler* const> samplers = {});
+
+		/**************************************************************************************************************
+		 * Renderer statistics.
+		 *
+		 * Statistics are reset when a frame is prepared, and then accumulate over every draw of the prepared frame.
+		 **************************************************************************************************************/
+		struct Stats {
+			/**********************************************************************************************************
+			 * The number of issued draw calls.
+			 **********************************************************************************************************/
+			std::size_t drawCalls{0};
+
+			/**********************************************************************************************************
+			 * The number of drawn vertices.
+			 **********************************************************************************************************/
+			std::size_t vertices{0};
+
+			/**********************************************************************************************************
+			 * The number of drawn indices.
+			 **********************************************************************************************************/
+			std::size_t indices{0};
+
+			/**********************************************************************************************************
+			 * The number of bytes uploaded to vertex and index buffers while preparing the frame.
+			 **********************************************************************************************************/
+			std::size_t uploadedBytes{0};
+
+			/**********************************************************************************************************
+			 * The number of texture changes.
+			 **********************************************************************************************************/
+			std::size_t textureChanges{0};
+
+			/**********************************************************************************************************
+			 * The number of sampler changes.
+			 **********************************************************************************************************/
+			std::size_t samplerChanges{0};
+
+			/**********************************************************************************************************
+			 * The number of blending mode changes.
+			 **********************************************************************************************************/
+			std::size_t blendModeChanges{0};
+
+			/**********************************************************************************************************
+			 * The number of primitives on every prepared layer.
+			 **********************************************************************************************************/
+			std::map<int, std::size_t> layerPrimitives;
+
+			/**********************************************************************************************************
+			 * The GPU time taken to draw every layer.
+			 *
+			 * Only measured while GPU timing is enabled. Timing results are read back once available, and so lag a few
+			 * frames behind, and are not reset when a frame is prepared.
+			 **********************************************************************************************************/
+			std::map<int, tr::Duration> layerGpuTimes;
+		};
+
+		/**************************************************************************************************************
+		 * Gets the renderer statistics.
+		 *
+		 * @return The statistics of the current prepared frame.
+		 **************************************************************************************************************/
+		const Stats& stats() const noexcept;
+
+		/**************************************************************************************************************
+		 * Sets whether the GPU time taken to draw every layer is measured.
+		 *
+		 * Timestamp queries are issued around every drawn layer and read back without stalling once their results
+		 * become available. If a draw would have to reuse queries whose results aren't available yet, it isn't timed.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] enabled Whether GPU timing should be enabled.
+		 **************************************************************************************************************/
+		void setGpuTimingEnabled(bool enabled);
+
+		/**************************************************************************************************************
+		 * Gets the graphics calls recorded by the null graphics backend.
+		 *
+		 * @pre The renderer must have been created with the null graphics backend.
+		 *
+		 * @return The graphics calls recorded since the renderer was created or the record was last cleared.
+		 **************************************************************************************************************/
+		const std::vector<GraphicsCall>& recordedCalls() const noexcept;
+
+		/**************************************************************************************************************
+		 * Clears the graphics calls recorded by the null graphics backend.
+		 *
+		 * @pre The renderer must have been created with the null graphics backend.
+		 **************************************************************************************************************/
+		void clearRecordedCalls() noexcept;
+
 	  private:
-		using TextureMesh = std::pair<std::vector<tr::TintVtx2>, std::vector<std::uint16_t>>;
-		using Primitive   = std::variant<TextureQuad, TextureFan, TextureMesh>;
+		// Allocator that default-initializes elements, so that growing a pool doesn't zero storage that's about to be
+		// written anyway.
+		template <class T> struct DefaultInitAllocator : std::allocator<T> {
+			using std::allocator<T>::allocator;
+
+			template <class U> struct rebind {
+				using other = DefaultInitAllocator<U>;
+			};
+
+			template <class U> void construct(U* ptr) noexcept(std::is_nothrow_default_constructible_v<U>)
+			{
+				::new (static_cast<void*>(ptr)) U;
+			}
+			template <class U, class... Args> void construct(U* ptr, Args&&... args)
+			{
+				::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+			}
+		};
+		// A fan or mesh primitive stored in the pools of its primitive list, with indices relative to its first vertex.
+		struct TextureMesh {
+			std::size_t firstVertex;
+			std::size_t vertices;
+			std::size_t firstIndex;
+			std::size_t indices;
+		};
+		using Primitive = std::variant<TextureQuad, TextureMesh>;
+		// The primitives of a layer. Fans and meshes share pooled storage to avoid allocating for every primitive.
+		struct PrimitiveList {
+			std::vector<Primitive>                                          primitives;
+			std::vector<tr::TintVtx2, DefaultInitAllocator<tr::TintVtx2>>   vertexPool;
+			std::vector<std::uint16_t, DefaultInitAllocator<std::uint16_t>> indexPool;
+
+			std::size_t size() const noexcept;
+			bool        empty() const noexcept;
+			void        clear() noexcept;
+			// Appends the primitives of another list, rebasing its meshes onto the pools of this one.
+			void append(const PrimitiveList& list);
+			// Adds a mesh primitive, returning spans over its storage in the pools.
+			TextureMeshSpans addMesh(std::size_t vertices, std::size_t indices);
+			// Adds a fan primitive as a mesh, returning a span over its vertices in the vertex pool.
+			std::span<tr::TintVtx2> addFan(std::size_t vertices);
+			// Gets the vertices and indices of a mesh primitive.
+			std::span<const tr::TintVtx2>  meshVertices(const TextureMesh& mesh) const noexcept;
+			std::span<const std::uint16_t> meshIndices(const TextureMesh& mesh) const noexcept;
+		};
+		// A single indexed draw call.
+		struct Draw {
+			enum class Type : std::uint8_t {
+				// Quads indexed from the shared index buffer.
+				QUADS,
+				// Fans and meshes indexed from the geometry's own index buffer.
+				MESHES
+			};
+
+			Type type;
+			// Offset to the first vertex of the draw, indices are relative to it.
+			std::size_t baseVertex;
+			// Offset to the first index of the draw in the used index buffer.
+			std::size_t offset;
+			std::size_t indices;
+			std::size_t vertices;
+		};
+		// Identifies a primitive for dirty-rectangle tracking.
+		struct PrimitiveSignature {
+			std::size_t hash;
+			// The bounding box of the primitive in layer space.
+			tr::RectF2 bounds;
+		};
+		struct LayerCache {
+			std::optional<tr::Texture2D> texture;
+			tr::Framebuffer              framebuffer;
+			// The transformation matrix the cache was rendered with.
+			glm::mat4 transform{};
+			bool      dirty{true};
+		};
+		struct RetainedGeometry {
+			// The buffers are empty under the null graphics backend.
+			std::optional<tr::VertexBuffer> vertexBuffer{};
+			std::optional<tr::IndexBuffer>  indexBuffer{};
+			std::vector<Draw>               draws;
+			// The number of primitives uploaded to the buffers.
+			std::size_t                     primitives{0};
+			std::vector<PrimitiveSignature> signatures;
+			std::optional<LayerCache>       cache{};
+		};
 		struct Layer {
-			const tr::Texture2D*   texture;
-			const tr::Sampler*     sampler;
+			const tr::Texture2D*            texture;
+			const tr::Sampler*              sampler;
+			glm::mat4                       transform;
+			tr::BlendMode                   blendMode;
+			PrimitiveList                   primitives{};
+			std::optional<RetainedGeometry> retained{};
+		};
+		struct PreparedLayer {
+			int                  priority;
+			const tr::Texture2D* texture;
+			const tr::Sampler*   sampler;
+			glm::mat4            transform;
+			tr::BlendMode        blendMode;
+			// nullptr if the layer is drawn from the shared buffers.
+			RetainedGeometry* retained;
+			std::size_t       firstDraw;
+			std::size_t       draws;
+			std::size_t       firstSignature;
+			std::size_t       signatures;
+		};
+		// A primitive as drawn to a view, for dirty-rectangle tracking.
+		struct DrawnPrimitive {
+			// Hash of the primitive and its layer's state.
+			std::size_t hash;
+			// The bounding box of the primitive in view pixels.
+			tr::RectI2 rect;
+
+			friend bool operator==(const DrawnPrimitive&, const DrawnPrimitive&) = default;
+		};
+		// Dirty-rectangle tracking state of a single view.
+		struct ViewTracking {
+			RenderView                  view;
+			std::vector<DrawnPrimitive> lastFrame;
+			// The regions that changed in each of the last bufferCount - 1 frames, oldest first.
+			std::vector<tr::RectI2>     changes;
+		};
+		struct DirtyRectTracking {
+			glm::vec4                   clearColor;
+			std::size_t                 bufferCount;
+			std::vector<ViewTracking>   views{};
+			// Scratch storage for the primitives of the frame being drawn.
+			std::vector<DrawnPrimitive> frame{};
+		};
+		// Owning wrapper over a growable set of OpenGL timestamp queries.
+		class TimestampQueries {
+		  public:
+			TimestampQueries() noexcept = default;
+			TimestampQueries(TimestampQueries&& r) noexcept = default;
+			~TimestampQueries() noexcept;
+
+			TimestampQueries& operator=(TimestampQueries&& r) noexcept;
+
+			std::size_t size() const noexcept;
+			// Creates queries until there are at least a given number of them.
+			void reserve(std::size_t size);
+			// Records the GPU time into a query once all previously issued commands have been processed.
+			void recordTimestamp(std::size_t query) noexcept;
+			bool available(std::size_t query) const noexcept;
+			// Gets the recorded timestamp of a query, in nanoseconds.
+			std::uint64_t result(std::size_t query) const noexcept;
+
+		  private:
+			std::vector<std::uint32_t> _queries;
+		};
+		// Timestamp queries issued during a single draw.
+		struct GpuTimerFrame {
+			// Pairs of start and end timestamp queries for every timed layer.
+			TimestampQueries queries;
+			std::vector<int> layers;
+			bool             pending{false};
+		};
+		// A multi-draw-indirect command, laid out as expected by OpenGL.
+		struct DrawIndirectCommand {
+			std::uint32_t count;
+			std::uint32_t instanceCount;
+			std::uint32_t firstIndex;
+			std::int32_t  baseVertex;
+			std::uint32_t baseInstance;
+		};
+		// Owning wrapper over an OpenGL buffer holding multi-draw-indirect commands.
+		class IndirectCommandBuffer {
+		  public:
+			IndirectCommandBuffer();
+			IndirectCommandBuffer(IndirectCommandBuffer&& r) noexcept;
+			~IndirectCommandBuffer() noexcept;
+
+			IndirectCommandBuffer& operator=(IndirectCommandBuffer&& r) noexcept;
+
+			// Replaces the contents of the buffer.
+			void set(std::span<const DrawIndirectCommand> commands) noexcept;
+			// Binds the buffer as the source of indirect draw commands.
+			void bind() const noexcept;
+			// Draws triangles with 16-bit indices using a range of the commands, the buffer must be bound.
+			void draw(std::size_t firstCommand, std::size_t commands) const noexcept;
+			void setLabel(std::string_view label) noexcept;
+
+		  private:
+			std::uint32_t _buffer;
+		};
+		struct MultiDrawIndirect {
+			// A single multi-draw-indirect call.
+			struct Call {
+				const std::optional<tr::VertexBuffer>* vertexBuffer;
+				const std::optional<tr::IndexBuffer>*  indexBuffer;
+				std::size_t                            firstCommand;
+				std::size_t                            commands;
+				std::size_t                            vertices;
+				std::size_t                            indices;
+			};
+
+			tr::OwningShaderPipeline         pipeline;
+			tr::ShaderBuffer                 transformBuffer;
+			IndirectCommandBuffer            commandBuffer{};
+			std::vector<DrawIndirectCommand> commands{};
+			// The transformation matrix of every command.
+			std::vector<glm::mat4> transforms{};
+			std::vector<Call>      calls{};
+		};
+		// The state set while drawing a frame, to avoid redundant calls and count state changes.
+		struct BoundState {
+			const tr::Texture2D*                   texture{nullptr};
+			const tr::Sampler*                     sampler{nullptr};
+			std::optional<tr::BlendMode>           blendMode{};
+			std::optional<glm::mat4>               transform{};
+			const std::optional<tr::VertexBuffer>* vertexBuffer{nullptr};
+			std::size_t                            baseVertex{0};
+			const std::optional<tr::IndexBuffer>*  indexBuffer{nullptr};
+		};
+
+		// The graphics objects are empty under the null graphics backend.
+		std::optional<tr::OwningShaderPipeline> _shaderPipeline;
+		std::optional<tr::TextureUnit>          _textureUnit;
+		std::optional<tr::IndexBuffer>          _sharedIndexBuffer;
+		std::optional<tr::VertexBuffer>         _cacheQuadBuffer;
+		std::optional<tr::VertexBuffer>         _vertexBuffer;
+		std::optional<tr::IndexBuffer>          _indexBuffer;
+		std::vector<tr::TintVtx2>               _vertices;
+		std::vector<std::uint16_t>              _indices;
+		std::vector<Draw>                       _draws;
+		std::map<int, Layer>                    _layers;
+		std::vector<PreparedLayer>              _preparedLayers;
+		// Signatures of the primitives of prepared non-retained layers.
+		std::vector<PrimitiveSignature>  _signatures;
+		std::optional<DirtyRectTracking> _dirtyRects;
+		Stats                            _stats;
+		// The size of the view shapes are approximated for.
+		glm::vec2 _targetViewSize{1920, 1080};
+		// Unit circle tables, indexed by segment count divided by the segment count granularity.
+		std::vector<std::vector<glm::vec2>> _unitCircles;
+		// GPU timing is disabled if there are no timer frames.
+		std::vector<GpuTimerFrame> _gpuTimerFrames;
+		std::size_t                _gpuTimerFrame{0};
+		// Only present under the null graphics backend.
+		std::optional<std::vector<GraphicsCall>> _recordedCalls;
+		// Only present while multi-draw-indirect submission is enabled.
+		std::optional<MultiDrawIndirect> _multiDraw;
+
+		bool nullGraphics() const noexcept;
+		// Records a graphics call if using the null graphics backend.
+		void record(GraphicsCall::Type type, std::size_t offset = 0, std::size_t size = 0);
+		// Uploads static data to the shared index buffer and cache quad vertex buffer.
+		void uploadStaticBuffers();
+		// Uploads data to a buffer, or records the upload if using the null graphics backend.
+		template <class Buffer, class Range> void upload(std::optional<Buffer>& buffer, const Range& data);
+		void setupContext() noexcept;
+		// Writes primitives to the vertex and index vectors and appends the needed draws to a list.
+		void writeToBuffers(const PrimitiveList& primitives, std::vector<Draw>& draws);
+		// Appends the signatures of primitives to a list.
+		static void signPrimitives(const PrimitiveList& primitives, std::vector<PrimitiveSignature>& signatures);
+		void uploadRetainedLayer(Layer& layer);
+		// Gets a unit circle approximated with a number of segments chosen for a radius on a layer.
+		std::span<const glm::vec2> unitCircle(int layer, float radius);
+		// Finds the region of the view that changed since the last drawn frame, or std::nullopt if nothing changed.
+		std::optional<tr::RectI2> findDirtyRect(const RenderView& view, const glm::mat4& viewTransform);
+		void setDrawState(BoundState& bound, const tr::Texture2D* texture, const tr::Sampler* sampler,
+						  const tr::BlendMode& blendMode);
+		void setTransform(BoundState& bound, const glm::mat4& transform);
+		void usePipeline(bool multiDraw);
+		void bindBuffers(BoundState& bound, const std::optional<tr::VertexBuffer>& vertexBuffer,
+						 std::size_t baseVertex, const std::optional<tr::IndexBuffer>& indexBuffer);
+		void drawIndexed(std::size_t offset, std::size_t indices, std::size_t vertices);
+		// Reads back the results of all pending timestamp queries that are available.
+		void collectGpuTimers();
+		void drawLayer(const PreparedLayer& layer, const glm::mat4& transform, BoundState& bound);
+		// Draws a run of compatible layers with multi-draw-indirect calls, returning the index of the first layer
+		// after the run.
+		std::size_t drawLayersIndirect(std::size_t firstLayer, const glm::mat4& viewTransform, BoundState& bound);
+		// Draws a cached layer, rerendering the cache if needed.
+		void drawCachedLayer(const PreparedLayer& layer, const RenderView& view, const tr::RectI2& scissorBox,
+							 const glm::mat4& transform, BoundState& bound);
+	};
+
+	/******************************************************************************************************************
+	 * Error thrown when decoding a frame capture fails.
+	 ******************************************************************************************************************/
+	class FrameCaptureDecodingError : public std::exception {
+	  public:
+		/**************************************************************************************************************
+		 * Constructs an error.
+		 *
+		 * @param[in] description A description of the error.
+		 **************************************************************************************************************/
+		FrameCaptureDecodingError(const char* description) noexcept;
+
+		/**************************************************************************************************************
+		 * Gets an error message.
+		 *
+		 * @return An explanatory error message.
+		 **************************************************************************************************************/
+		virtual const char* what() const noexcept;
+
+	  private:
+		const char* _description;
+	};
+
+	class Renderer2D::FrameCapture {
+	  public:
+		/**************************************************************************************************************
+		 * Loads a frame capture from a stream.
+		 *
+		 * @exception FrameCaptureDecodingError If decoding the capture fails.
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] is A binary input stream positioned at the start of a capture.
+		 **************************************************************************************************************/
+		explicit FrameCapture(std::istream& is);
+
+		/**************************************************************************************************************
+		 * Saves the frame capture to a stream.
+		 *
+		 * Multiple captures can be saved to the same stream one after another.
+		 *
+		 * @param[in] os A binary output stream.
+		 **************************************************************************************************************/
+		void save(std::ostream& os) const;
+
+		/**************************************************************************************************************
+		 * Gets the number of distinct textures used by the capture.
+		 *
+		 * @return The size of the capture's texture table.
+		 **************************************************************************************************************/
+		std::size_t textureCount() const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the number of distinct samplers used by the capture.
+		 *
+		 * @return The size of the capture's sampler table.
+		 **************************************************************************************************************/
+		std::size_t samplerCount() const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the number of captured primitives.
+		 *
+		 * @return The total number of primitives on all captured layers.
+		 **************************************************************************************************************/
+		std::size_t primitiveCount() const noexcept;
+
+	  private:
+		struct CapturedLayer {
+			int priority;
+			// Index into the texture and sampler tables, or -1 for color-only layers.
+			std::int32_t           texture;
+			std::int32_t           sampler;
 			glm::mat4              transform;
 			tr::BlendMode          blendMode;
-			std::vector<Primitive> primitives;
+			bool                   retained;
+			PrimitiveList          primitives;
 		};
 
-		tr::OwningShaderPipeline   _shaderPipeline;
-		tr::TextureUnit            _textureUnit;
-		tr::VertexBuffer           _vertexBuffer;
-		tr::IndexBuffer            _indexBuffer;
-		std::vector<tr::TintVtx2>  _vertices;
-		std::vector<std::uint16_t> _indices;
-		std::map<int, Layer>       _layers;
-
-		void                     setupContext() noexcept;
-		std::uint16_t            writeToBuffers(const Primitive& primitive, std::uint16_t index);
-		std::vector<std::size_t> uploadToGraphicsBuffers(decltype(_layers)::iterator end);
+		std::vector<CapturedLayer> _layers;
+		std::size_t                _textures{0};
+		std::size_t                _samplers{0};
+
+		FrameCapture() noexcept = default;
+
+		friend class Renderer2D;
 	};
 
 	/******************************************************************************************************************
@@ -117,6 +117,121 @@ namespace tre {
 	 ******************************************************************************************************************/
 	inline constexpr TextOutline NO_OUTLINE{0, {0, 0, 0, 0}};
 
+	/******************************************************************************************************************
+	 * Measurements of laid out text.
+	 ******************************************************************************************************************/
+	struct TextMetrics {
+		/**************************************************************************************************************
+		 * The number of lines of the text.
+		 **************************************************************************************************************/
+		std::size_t lines;
+
+		/**************************************************************************************************************
+		 * The size of the bounding box of the text.
+		 **************************************************************************************************************/
+		glm::vec2 size;
+	};
+
+	/******************************************************************************************************************
+	 * Formatted text parsed into runs of uniformly styled plain text.
+	 *
+	 * Parsing the escape sequences described in @ref renderformat only has to be done once, so formatted text that is
+	 * drawn repeatedly or laid out again with different textbox sizes (like localized strings) can be parsed ahead of
+	 * time and passed to the formatted text functions in place of the string.
+	 ******************************************************************************************************************/
+	class RichText {
+	  public:
+		/**************************************************************************************************************
+		 * A run of text with a single style.
+		 **************************************************************************************************************/
+		struct Run {
+			/**********************************************************************************************************
+			 * The byte offset of the start of the run in the plain text.
+			 **********************************************************************************************************/
+			std::size_t begin;
+
+			/**********************************************************************************************************
+			 * The byte offset of the end of the run in the plain text.
+			 **********************************************************************************************************/
+			std::size_t end;
+
+			/**********************************************************************************************************
+			 * The index of the color of the run in the span of colors passed when drawing, or DEFAULT_COLOR.
+			 *
+			 * If the index is out of the span's range, the color of the previous run is kept.
+			 **********************************************************************************************************/
+			std::uint8_t color;
+
+			/**********************************************************************************************************
+			 * Whether the run is bold.
+			 **********************************************************************************************************/
+			bool bold;
+
+			/**********************************************************************************************************
+			 * Whether the run is italic.
+			 **********************************************************************************************************/
+			bool italic;
+
+			/**********************************************************************************************************
+			 * Whether the run is underlined.
+			 **********************************************************************************************************/
+			bool underline;
+
+			/**********************************************************************************************************
+			 * Whether the run is striked out.
+			 **********************************************************************************************************/
+			bool strikethrough;
+
+			/**********************************************************************************************************
+			 * Equality comparison operator.
+			 **********************************************************************************************************/
+			friend bool operator==(const Run&, const Run&) = default;
+		};
+
+		/**************************************************************************************************************
+		 * Color index representing the default color (see <code>\\!</code> in @ref renderformat).
+		 **************************************************************************************************************/
+		static constexpr std::uint8_t DEFAULT_COLOR{255};
+
+		/**************************************************************************************************************
+		 * Parses formatted text.
+		 *
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] formatted The text to parse. See @ref renderformat for the specifics of the text format.
+		 **************************************************************************************************************/
+		explicit RichText(std::string_view formatted);
+
+		/**************************************************************************************************************
+		 * Gets the plain text, with all escape sequences resolved.
+		 *
+		 * @return A view over the plain text.
+		 **************************************************************************************************************/
+		std::string_view text() const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the text of a run.
+		 *
+		 * @param[in] run A run of this text.
+		 *
+		 * @return A view over the plain text of the run.
+		 **************************************************************************************************************/
+		std::string_view text(const Run& run) const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the runs of the text.
+		 *
+		 * Runs are ordered and cover the whole plain text. Runs may only be empty if they change the color.
+		 *
+		 * @return A span over the runs of the text.
+		 **************************************************************************************************************/
+		std::span<const Run> runs() const noexcept;
+
+	  private:
+		std::string      _text;
+		std::vector<Run> _runs;
+	};
+
 	/******************************************************************************************************************
 	 * Renders text to a bitmap according to the format described in @ref renderformat.
 	 *
@@ -127,7 +242,12 @@ namespace tre {
 	 * @exception std::bad_alloc If an internal allocation occurs.
 	 * @exception tr::BitmapBadAlloc If allocating a bitmap fails.
 	 *
-	 * @param[in] text The text to render. Must not be an empty string or one solely consisting of control sequences.
+	 * @param[in] text
+	 * @parblock
+	 * The text to render. Text solely consisting of control sequences produces an empty bitmap.
+	 *
+	 * @pre @em text must not be an empty string.
+	 * @endparblock
 	 * @param[in] font The font to use in rendering.
 	 * @param[in] size The size of the font.
 	 * @param[in] dpi The dpi to use for the text.
@@ -142,5 +262,85 @@ namespace tre {
 	tr::Bitmap renderMultistyleText(std::string_view text, tr::TTFont& font, int size, glm::uvec2 dpi, int maxWidth,
 									HorizontalAlign alignment, std::span<tr::RGBA8> textColors, TextOutline outline);
 
+	/******************************************************************************************************************
+	 * Renders parsed formatted text to a bitmap.
+	 *
+	 * @par Exception Safety
+	 *
+	 * Strong exception guarantee.
+	 *
+	 * @exception std::bad_alloc If an internal allocation occurs.
+	 * @exception tr::BitmapBadAlloc If allocating a bitmap fails.
+	 *
+	 * @param[in] text The text to render. Text with empty plain text produces an empty bitmap.
+	 * @param[in] font The font to use in rendering.
+	 * @param[in] size The size of the font.
+	 * @param[in] dpi The dpi to use for the text.
+	 * @param[in] maxWidth The width limit of the resulting bitmap.
+	 * @param[in] alignment The alignment of the text within the bitmap.
+	 * @param[in] textColors The colors to use when rendering the text. The span cannot be empty.
+	 *                       By default, the color at index 0 is used.
+	 * @param[in] outline The outline parameters to use for the text, or NO_OUTLINE.
+	 *
+	 * @return A bitmap containing the text.
+	 ******************************************************************************************************************/
+	tr::Bitmap renderMultistyleText(const RichText& text, tr::TTFont& font, int size, glm::uvec2 dpi, int maxWidth,
+									HorizontalAlign alignment, std::span<tr::RGBA8> textColors, TextOutline outline);
+
+	/******************************************************************************************************************
+	 * Measures text laid out like renderMultistyleText() would, without rendering it.
+	 *
+	 * Results are memoized per font, size, dpi, width limit and outline, so measuring the same text again is a lookup.
+	 * The memoized results are identified by the address of the font, so clearMultistyleTextMetrics() must be called
+	 * when a font that was measured with is destroyed.
+	 *
+	 * @exception std::bad_alloc If an internal allocation occurs.
+	 *
+	 * @param[out] lineWidths
+	 * @parblock
+	 * The storage to write the widths of the lines into, excluding the outline. If it is too small, only the widths of
+	 * the first lines are written.
+	 * @endparblock
+	 * @param[in] text The text to measure. See @ref renderformat for the specifics of the text format.
+	 * @param[in] font The font to use in measuring. Its size, style and outline are changed.
+	 * @param[in] size The size of the font.
+	 * @param[in] dpi The dpi to use for the text.
+	 * @param[in] maxWidth The width limit of the text.
+	 * @param[in] outline The outline parameters to use for the text, or NO_OUTLINE.
+	 *
+	 * @return The metrics of the text, in pixels at the given dpi.
+	 ******************************************************************************************************************/
+	TextMetrics measureMultistyleText(std::span<float> lineWidths, std::string_view text, tr::TTFont& font, int size,
+									  glm::uvec2 dpi, int maxWidth, TextOutline outline);
+
+	/******************************************************************************************************************
+	 * Measures parsed formatted text laid out like renderMultistyleText() would, without rendering it.
+	 *
+	 * Results are memoized like those of the string version of the function.
+	 *
+	 * @exception std::bad_alloc If an internal allocation occurs.
+	 *
+	 * @param[out] lineWidths
+	 * @parblock
+	 * The storage to write the widths of the lines into, excluding the outline. If it is too small, only the widths of
+	 * the first lines are written.
+	 * @endparblock
+	 * @param[in] text The text to measure.
+	 * @param[in] font The font to use in measuring. Its size, style and outline are changed.
+	 * @param[in] size The size of the font.
+	 * @param[in] dpi The dpi to use for the text.
+	 * @param[in] maxWidth The width limit of the text.
+	 * @param[in] outline The outline parameters to use for the text, or NO_OUTLINE.
+	 *
+	 * @return The metrics of the text, in pixels at the given dpi.
+	 ******************************************************************************************************************/
+	TextMetrics measureMultistyleText(std::span<float> lineWidths, const RichText& text, tr::TTFont& font, int size,
+									  glm::uvec2 dpi, int maxWidth, TextOutline outline);
+
+	/******************************************************************************************************************
+	 * Clears the memoized results of measureMultistyleText().
+	 ******************************************************************************************************************/
+	void clearMultistyleTextMetrics() noexcept;
+
 	/// @}
 } // namespace tre
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+#include "atlas.hpp"
+#include "renderer_2d.hpp"
+
+namespace tre {
+	/** @defgroup tilemap Tilemap
+	 *  Tilemap rendering functionality.
+	 *
+	 *  @{
+	 */
+
+	/******************************************************************************************************************
+	 * Chunked tilemap renderer.
+	 *
+	 * The tilemap is split into square chunks, each of which has its own mesh on the GPU. A chunk's mesh is only
+	 * rebuilt and reuploaded when one of its tiles changes, and chunks outside of the view aren't drawn, so the
+	 * per-frame cost of drawing the tilemap depends on the number of visible chunks rather than tiles.
+	 *
+	 * Tile @em (x, y) spans the rectangle from @em (x, y) * tileSize() to @em (x + 1, y + 1) * tileSize().
+	 *
+	 * @note An instance of tr::Window must be created before Tilemap can be instantiated.
+	 ******************************************************************************************************************/
+	class Tilemap {
+	  public:
+		/**************************************************************************************************************
+		 * The width and height of a chunk in tiles.
+		 **************************************************************************************************************/
+		static constexpr int CHUNK_SIZE{32};
+
+		/**************************************************************************************************************
+		 * Creates an empty tilemap.
+		 *
+		 * @exception tr::GLBufferBadAlloc If an internal allocation fails.
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] atlas
+		 * @parblock
+		 * The atlas the tiles are taken from.
+		 *
+		 * @warning The atlas reference must stay valid for as long as the tilemap uses it.
+		 * @endparblock
+		 * @param[in] size The size of the tilemap in tiles.
+		 * @param[in] tileSize The size of a tile.
+		 **************************************************************************************************************/
+		Tilemap(const Atlas2D& atlas, glm::ivec2 size, glm::vec2 tileSize);
+
+		/**************************************************************************************************************
+		 * Move-constructs a tilemap.
+		 *
+		 * @param[in] r The tilemap to move from. @em r will be left in a moved-from state that shouldn't be used.
+		 **************************************************************************************************************/
+		Tilemap(Tilemap&& r) noexcept;
+
+		/**************************************************************************************************************
+		 * Destroys the tilemap.
+		 **************************************************************************************************************/
+		~Tilemap() noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the size of the tilemap.
+		 *
+		 * @return The size of the tilemap in tiles.
+		 **************************************************************************************************************/
+		glm::ivec2 size() const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets the size of a tile.
+		 *
+		 * @return The size of a tile.
+		 **************************************************************************************************************/
+		glm::vec2 tileSize() const noexcept;
+
+		/**************************************************************************************************************
+		 * Gets a tile.
+		 *
+		 * @param[in] pos
+		 * @parblock
+		 * The position of the tile.
+		 *
+		 * @pre @em pos must be within the tilemap.
+		 * @endparblock
+		 *
+		 * @return The handle to the atlas entry of the tile, or std::nullopt if the tile is empty.
+		 **************************************************************************************************************/
+		std::optional<Atlas2D::Handle> tile(glm::ivec2 pos) const noexcept;
+
+		/**************************************************************************************************************
+		 * Sets a tile.
+		 *
+		 * @param[in] pos
+		 * @parblock
+		 * The position of the tile.
+		 *
+		 * @pre @em pos must be within the tilemap.
+		 * @endparblock
+		 * @param[in] tile The handle to the atlas entry of the tile, or std::nullopt to make the tile empty.
+		 **************************************************************************************************************/
+		void setTile(glm::ivec2 pos, std::optional<Atlas2D::Handle> tile) noexcept;
+
+		/**************************************************************************************************************
+		 * Draws the visible chunks of the tilemap.
+		 *
+		 * Chunks with changed tiles are rebuilt and reuploaded before being drawn.
+		 *
+		 * @exception tr::GLBufferBadAlloc If an internal allocation fails.
+		 * @exception std::bad_alloc If an internal allocation fails.
+		 *
+		 * @param[in] view The view to draw to.
+		 * @param[in] layer
+		 * @parblock
+		 * The Renderer2D layer whose sampler, transformation matrix and blending mode are used. The atlas texture is
+		 * used in place of the layer's texture.
+		 *
+		 * @pre The 2D renderer must be instantiated and have a layer with priority @em layer.
+		 *
+		 * @pre The layer must not be color-only.
+		 * @endparblock
+		 **************************************************************************************************************/
+		void draw(const RenderView& view, int layer);
+
+	  private:
+		struct Chunk {
+			tr::VertexBuffer vertexBuffer;
+			std::size_t      indices;
+			bool             dirty;
+		};
+
+		tr::OwningShaderPipeline _shaderPipeline;
+		tr::TextureUnit          _textureUnit;
+		tr::IndexBuffer          _indexBuffer;
+
+		std::reference_wrapper<const Atlas2D> _atlas;
+		glm::ivec2                            _size;
+		glm::vec2                             _tileSize;
+		std::vector<Atlas2D::Handle>          _tiles;
+		std::vector<Chunk>                    _chunks;
+		std::vector<tr::TintVtx2>             _vertices;
+
+		glm::ivec2 chunkCount() const noexcept;
+		void       rebuildChunk(glm::ivec2 chunk);
+		void       setupContext(const tr::BlendMode& blendMode) noexcept;
+	};
+
+	/// @}
+} // namespace tre
\ No newline at end of file
@@ -2,15 +2,20 @@
 #include "atlas.hpp"
 #include "audio.hpp"
 #include "bitmap_text_manager.hpp"
+#include "bitmap_text_renderer.hpp"
 #include "debug_text_renderer.hpp"
 #include "dynamic_text_manager.hpp"
+#include "graphics_state.hpp"
 #include "localization_manager.hpp"
+#include "null_graphics.hpp"
+#include "particle_system.hpp"
 #include "render_view.hpp"
 #include "renderer_2d.hpp"
 #include "sampler.hpp"
 #include "state_manager.hpp"
 #include "static_text_manager.hpp"
 #include "text.hpp"
+#include "tilemap.hpp"
 
 /// Namespace containing all libtre functionality.
 namespace tre {
@@ -0,0 +1,55 @@
+#version 450
+
+const uint  ITALIC_GLYPH_INSTANCE = 0x80000000u;
+const float TAN_12_5_DEG          = 0.22169466264;
+
+struct GlyphInstance {
+	vec2 pos;
+	uint scale;
+	uint rotation;
+	uint glyph;
+	uint tint;
+};
+
+struct GlyphMetrics {
+	vec2 offset;
+	vec2 size;
+	vec2 uvTL;
+	vec2 uvSize;
+};
+
+layout(std430, binding = 0) buffer b_glyphs
+{
+	GlyphInstance glyphs[];
+};
+
+layout(std430, binding = 1) buffer b_metrics
+{
+	GlyphMetrics metrics[];
+};
+
+layout(location = 0) uniform mat4 u_transform;
+
+layout(location = 0) in vec2 v_offset;
+
+layout(location = 0) out vec2 vf_uv;
+layout(location = 1) out vec4 vf_color;
+
+void main()
+{
+	const GlyphInstance glyph    = glyphs[gl_InstanceID];
+	const GlyphMetrics  metric   = metrics[glyph.glyph & ~ITALIC_GLYPH_INSTANCE];
+	const vec2          scale    = unpackHalf2x16(glyph.scale);
+	const vec2          rotation = unpackSnorm2x16(glyph.rotation);
+	const vec2          size     = metric.size * scale;
+
+	vec2 offset = metric.offset * scale + v_offset * size;
+	if ((glyph.glyph & ITALIC_GLYPH_INSTANCE) != 0u && v_offset.y == 0.0) {
+		offset.x += size.y * TAN_12_5_DEG;
+	}
+	offset = vec2(offset.x * rotation.x - offset.y * rotation.y, offset.x * rotation.y + offset.y * rotation.x);
+
+	vf_uv       = metric.uvTL + v_offset * metric.uvSize;
+	vf_color    = unpackUnorm4x8(glyph.tint);
+	gl_Position = u_transform * vec4(glyph.pos + offset, 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#version 450
+
+#define UNTEXTURED_UV vec2(-100, -100)
+
+struct Particle {
+	vec2  pos;
+	float size;
+	uint  color;
+	vec2  uvTL;
+	vec2  uvSize;
+};
+
+layout(std430, binding = 0) buffer b_particles
+{
+	Particle particles[];
+};
+
+layout(location = 0) uniform mat4 u_transform;
+layout(location = 1) uniform int u_textured;
+
+layout(location = 0) in vec2 v_offset;
+
+layout(location = 0) out vec2 vf_uv;
+layout(location = 1) out vec4 vf_color;
+
+void main()
+{
+	const Particle particle = particles[gl_InstanceID];
+
+	vf_uv       = u_textured != 0 ? particle.uvTL + v_offset * particle.uvSize : UNTEXTURED_UV;
+	vf_color    = unpackUnorm4x8(particle.color);
+	gl_Position = u_transform * vec4(particle.pos + (v_offset - 0.5) * particle.size, 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#version 460
+
+layout(std430, binding = 0) readonly buffer b_transforms
+{
+	mat4 transforms[];
+};
+
+layout(location = 0) uniform int u_firstDraw;
+layout(location = 0) in vec2 v_pos;
+layout(location = 1) in vec2 v_uv;
+layout(location = 2) in vec4 v_color;
+layout(location = 0) out vec2 vf_uv;
+layout(location = 1) out vec4 vf_color;
+
+void main()
+{
+	vf_uv       = v_uv;
+	vf_color    = v_color;
+	gl_Position = transforms[u_firstDraw + gl_DrawID] * vec4(v_pos, 0.0, 1.0);
+}
\ No newline at end of file
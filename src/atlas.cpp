@@ -1,4 +1,5 @@
 #include "../include/tre/atlas.hpp"
+#include "../include/tre/graphics_state.hpp"
 
 using NamedBitmaps  = tr::StringHashMap<tr::Bitmap>;
 using NamedBitmapIt = NamedBitmaps::const_iterator;
@@ -151,8 +152,10 @@ tre::Atlas2D::Atlas2D(AtlasBitmap atlasBitmap)
 	: _tex{atlasBitmap.bitmap, tr::ALL_MIPMAPS, tr::TextureFormat::RGBA8}
 {
 	const auto size{glm::vec2(atlasBitmap.bitmap.size())};
+	_entries.reserve(atlasBitmap.entries.size());
 	for (auto& [name, rect] : atlasBitmap.entries) {
-		_entries.emplace(std::move(name), tr::RectF2{glm::vec2(rect.tl) / size, glm::vec2(rect.size) / size});
+		_handles.emplace(std::move(name), Handle(_entries.size()));
+		_entries.push_back({glm::vec2(rect.tl) / size, glm::vec2(rect.size) / size});
 	}
 }
 
@@ -163,13 +166,24 @@ tre::Atlas2D::Atlas2D(const tr::StringHashMap<tr::Bitmap>& bitmaps)
 
 bool tre::Atlas2D::contains(std::string_view name) const noexcept
 {
-	return _entries.contains(name);
+	return _handles.contains(name);
 }
 
 const tr::RectF2& tre::Atlas2D::operator[](std::string_view name) const noexcept
+{
+	return (*this)[handle(name)];
+}
+
+tre::Atlas2D::Handle tre::Atlas2D::handle(std::string_view name) const noexcept
 {
 	assert(contains(name));
-	return _entries.find(name)->second;
+	return _handles.find(name)->second;
+}
+
+const tr::RectF2& tre::Atlas2D::operator[](Handle handle) const noexcept
+{
+	assert(std::size_t(handle) < _entries.size());
+	return _entries[std::size_t(handle)];
 }
 
 const tr::Texture2D& tre::Atlas2D::texture() const noexcept
@@ -236,6 +250,8 @@ void tre::DynAtlas2D::rawReserve(glm::ivec2 capacity)
 		dynArrayCopyFBO.attach(*_tex, tr::Framebuffer::Slot::COLOR0);
 		dynArrayCopyFBO.copyRegion({{}, oldCapacity}, newTex, {});
 		_tex = std::move(newTex);
+		// The copy binds a framebuffer and the texture is replaced in place, so the cached state is stale.
+		graphicsState().invalidate();
 	}
 	if (!_label.empty()) {
 		_tex->setLabel(_label);
@@ -314,8 +330,8 @@ void tre::DynAtlas2D::remove(std::string_view name) noexcept
 {
 	auto it{_entries.find(name)};
 	if (it != _entries.end()) {
-		_entries.erase(it);
 		_freeRects.emplace_front(it->second.tl, it->second.size);
+		_entries.erase(it);
 	}
 }
 
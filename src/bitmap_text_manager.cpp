@@ -1,194 +1,187 @@
 #include "../include/tre/bitmap_text_manager.hpp"
 #include "../include/tre/renderer_2d.hpp"
-#include <numeric>
+#include <bit>
+#include <cstring>
+#include <latch>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace tr::angle_literals;
 using namespace tr::matrix_operators;
 
 namespace tre {
 	BitmapTextManager* _bitmapText{nullptr};
+	// The maximum number of glyph quads in a single mesh added to a 2D renderer layer.
+	constexpr std::size_t MAX_TEXT_MESH_QUADS{(std::numeric_limits<std::uint16_t>::max() + 1) / 4};
+	// The minimum number of text requests worth handing to a separate thread.
+	constexpr std::size_t MIN_TEXT_REQUESTS_PER_THREAD{16};
+
+	// Gets the initial vertical offset for text in a textbox.
+	float initialOffsetY(std::size_t lines, float lineHeight, const BitmapTextManager::Textbox& textbox) noexcept;
 
-	// Measures the longest string that fits within a certain width.
-	std::string_view measureUnformatted(std::string_view text, const BitmapTextManager::GlyphMap& font, float scale,
-										float maxWidth) noexcept;
+	// Gets the initial horizontal offset for a line of text in a textbox.
+	float initialOffsetX(float lineWidth, const BitmapTextManager::Textbox& textbox) noexcept;
 
-	// Measures the longest string that fits within a certain width.
-	std::string_view measureFormatted(std::string_view text, const BitmapTextManager::GlyphMap& font, float scale,
-									  float maxWidth) noexcept;
+	// Gets the rotation transform of a textbox, or std::nullopt if it isn't rotated.
+	std::optional<glm::mat4> textboxTransform(const BitmapTextManager::Textbox& textbox) noexcept;
 
-	// Splits a text string into lines.
-	std::vector<std::string_view> splitText(std::string_view text, const BitmapTextManager::GlyphMap& font, float scale,
-											float maxWidth, bool formatted);
+	// Gets whether a character is ASCII and laid out as a plain glyph, that is anything but a newline, space or tab, or
+	// a backslash in formatted text.
+	bool plainAscii(char chr, bool formatted) noexcept;
 
-	// Gets the initial offset for text in a textbox.
-	float initialOffsetY(const std::vector<std::string_view>& lines, float lineSkip,
-						 const BitmapTextManager::Textbox& textbox) noexcept;
+	// Gets the length of the prefix of a string made up of plain ASCII characters, scanning several bytes at a time.
+	std::size_t plainAsciiPrefixLength(std::string_view text, bool formatted) noexcept;
 
-	// Gets the initial offset for a line of text.
-	float initialUnformattedOffsetX(std::string_view line, const BitmapTextManager::GlyphMap& font, float scale,
-									const BitmapTextManager::Textbox& textbox) noexcept;
+	// Gets the length of the prefix of a string without any ASCII characters.
+	std::size_t nonAsciiPrefixLength(std::string_view text) noexcept;
 
-	// Gets the initial offset for a line of text.
-	float initialFormattedOffsetX(std::string_view line, const BitmapTextManager::GlyphMap& font, float scale,
-								  const BitmapTextManager::Textbox& textbox) noexcept;
+	// Removes the first UTF-8 character of a string.
+	void removeCharacter(std::string_view& text) noexcept;
 } // namespace tre
 
-std::string_view tre::measureUnformatted(std::string_view text, const BitmapTextManager::GlyphMap& font, float scale,
-										 float maxWidth) noexcept
+float tre::initialOffsetY(std::size_t lines, float lineHeight, const BitmapTextManager::Textbox& textbox) noexcept
 {
-	float lineWidth{};
-	for (auto it = tr::utf8Begin(text); it != tr::utf8End(text); ++it) {
-		if (*it == '\n') {
-			return {text.begin(), (const char*)(it)};
-		}
+	const float textboxTop{textbox.pos.y - textbox.posAnchor.y};
+	switch (VerticalAlign(textbox.textAlignment)) {
+	case VerticalAlign::TOP:
+		return textboxTop;
+	case VerticalAlign::CENTER:
+		return textboxTop + (textbox.size.y - lines * lineHeight) / 2.0f;
+	case VerticalAlign::BOTTOM:
+		return textboxTop + textbox.size.y - lines * lineHeight;
+	}
+}
 
-		lineWidth += font.at(font.contains(*it) ? *it : '\0').advance * scale;
-		if (it != text.begin() && lineWidth > maxWidth) {
-			return {text.begin(), (const char*)(it)};
-		}
+float tre::initialOffsetX(float lineWidth, const BitmapTextManager::Textbox& textbox) noexcept
+{
+	const float textboxLeft{textbox.pos.x - textbox.posAnchor.x};
+	switch (HorizontalAlign(textbox.textAlignment)) {
+	case HorizontalAlign::LEFT:
+		return textboxLeft;
+	case HorizontalAlign::CENTER:
+		return textboxLeft + (textbox.size.x - lineWidth) / 2.0f;
+	case HorizontalAlign::RIGHT:
+		return textboxLeft + textbox.size.x - lineWidth;
 	}
-	return text;
 }
 
-std::string_view tre::measureFormatted(std::string_view text, const BitmapTextManager::GlyphMap& font, float scale,
-									   float maxWidth) noexcept
+std::optional<glm::mat4> tre::textboxTransform(const BitmapTextManager::Textbox& textbox) noexcept
 {
-	float lineWidth{};
-	for (auto it = tr::utf8Begin(text); it != tr::utf8End(text); ++it) {
-		if (*it == '\n') {
-			return {text.begin(), (const char*)(it)};
-		}
-		else if (*it == '\\') {
-			if (++it != text.end() && *it == '\\') {
-				lineWidth += font.at(font.contains('\\') ? '\\' : '\0').advance * scale;
-			}
-		}
-		else {
-			lineWidth += font.at(font.contains(*it) ? *it : '\0').advance * scale;
-			if (it != text.begin() && lineWidth > maxWidth) {
-				return {text.begin(), (const char*)(it)};
-			}
-		}
+	if (textbox.rotation == 0_degf) {
+		return std::nullopt;
 	}
-	return text;
+	return tr::rotateAroundPoint2(glm::mat4{1}, textbox.pos, textbox.rotation);
 }
 
-std::vector<std::string_view> tre::splitText(std::string_view text, const BitmapTextManager::GlyphMap& font,
-											 float scale, float maxWidth, bool formatted)
+bool tre::plainAscii(char chr, bool formatted) noexcept
 {
-	std::vector<std::string_view> lines;
+	return (chr & 0x80) == 0 && chr != '\n' && chr != ' ' && chr != '\t' && (!formatted || chr != '\\');
+}
 
-	for (auto it = text.begin(); it != text.end();) {
-		auto fit{formatted ? measureFormatted({it, text.end()}, font, scale, maxWidth)
-						   : measureUnformatted({it, text.end()}, font, scale, maxWidth)};
-		if (fit.end() == text.end()) {
-			lines.push_back(fit);
-			return lines;
+std::size_t tre::plainAsciiPrefixLength(std::string_view text, bool formatted) noexcept
+{
+	std::size_t length{0};
+#ifdef __SSE2__
+	// Unformatted text compares against the newline twice instead of branching.
+	const __m128i newline{_mm_set1_epi8('\n')};
+	const __m128i space{_mm_set1_epi8(' ')};
+	const __m128i tab{_mm_set1_epi8('\t')};
+	const __m128i backslash{_mm_set1_epi8(formatted ? '\\' : '\n')};
+	for (; length + 16 <= text.size(); length += 16) {
+		const __m128i bytes{_mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + length))};
+		const __m128i special{_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, newline), _mm_cmpeq_epi8(bytes, space)),
+										   _mm_or_si128(_mm_cmpeq_epi8(bytes, tab), _mm_cmpeq_epi8(bytes, backslash)))};
+		// The mask has a bit set for every special byte and for every byte with its high bit set, that is every
+		// non-ASCII byte.
+		const int mask{_mm_movemask_epi8(_mm_or_si128(bytes, special))};
+		if (mask != 0) {
+			return length + std::countr_zero(unsigned(mask));
 		}
-		else {
-			const auto whitespaceSearchRange{std::ranges::subrange{fit.begin(), std::next(fit.end())} |
-											 std::views::reverse};
-			const auto lastWhitespace{std::ranges::find_first_of(whitespaceSearchRange, " \t\n")};
-			if (lastWhitespace != whitespaceSearchRange.end()) {
-				lines.push_back({it, std::prev(lastWhitespace.base())});
-				it = lastWhitespace.base();
-			}
-			else {
-				lines.push_back(fit);
-				it = fit.end();
-			}
+	}
+#else
+	// Sets the high bit of every byte of a word equal to the byte a pattern is made of. Bits above the first match may
+	// be set spuriously, which doesn't matter here as only the presence of a match is checked.
+	const auto matches{[](std::uint64_t word, char chr) {
+		const std::uint64_t difference{word ^ (0x0101010101010101 * std::uint8_t(chr))};
+		return (difference - 0x0101010101010101) & ~difference & 0x8080808080808080;
+	}};
+	for (; length + sizeof(std::uint64_t) <= text.size(); length += sizeof(std::uint64_t)) {
+		std::uint64_t word;
+		std::memcpy(&word, text.data() + length, sizeof(word));
+		if (((word & 0x8080808080808080) | matches(word, '\n') | matches(word, ' ') | matches(word, '\t') |
+			 (formatted ? matches(word, '\\') : 0)) != 0) {
+			break;
 		}
 	}
-#if defined(_MSC_VER) && !defined(__clang__) // MSVC
-	__assume(false);
-#else // GCC, Clang
-	__builtin_unreachable();
 #endif
+	while (length < text.size() && plainAscii(text[length], formatted)) {
+		++length;
+	}
+	return length;
 }
 
-float tre::initialOffsetY(const std::vector<std::string_view>& lines, float lineSkip,
-						  const BitmapTextManager::Textbox& textbox) noexcept
+std::size_t tre::nonAsciiPrefixLength(std::string_view text) noexcept
 {
-	float textboxTop{textbox.pos.y - textbox.posAnchor.y};
-	switch (VerticalAlign(textbox.textAlignment)) {
-	case VerticalAlign::TOP:
-		return textboxTop;
-	case VerticalAlign::CENTER:
-		return textboxTop + (textbox.size.y - (lines.size() * lineSkip)) / 2.0f;
-	case VerticalAlign::BOTTOM:
-		return textboxTop + textbox.size.y - (lines.size() * lineSkip);
+	std::size_t length{0};
+	while (length < text.size() && (text[length] & 0x80) != 0) {
+		++length;
 	}
+	return length;
 }
 
-float tre::initialUnformattedOffsetX(std::string_view line, const BitmapTextManager::GlyphMap& font, float scale,
-									 const BitmapTextManager::Textbox& textbox) noexcept
+void tre::removeCharacter(std::string_view& text) noexcept
 {
-	const float textboxLeft{textbox.pos.x - textbox.posAnchor.x};
-	const auto  pred{[&](float sum, std::uint32_t codepoint) {
-        return sum + font.at(font.contains(codepoint) ? codepoint : '\0').advance * scale;
-    }};
-
-	switch (HorizontalAlign(textbox.textAlignment)) {
-	case HorizontalAlign::LEFT:
-		return textboxLeft;
-	case HorizontalAlign::CENTER:
-		return (textboxLeft + std::accumulate(tr::utf8Begin(line), tr::utf8End(line), 0.0f, pred)) / 2.0f;
-	case HorizontalAlign::RIGHT:
-		return textboxLeft + std::accumulate(tr::utf8Begin(line), tr::utf8End(line), 0.0f, pred);
+	text.remove_prefix(1);
+	while (!text.empty() && (text[0] & 0xC0) == 0x80) {
+		text.remove_prefix(1);
 	}
 }
 
-float tre::initialFormattedOffsetX(std::string_view line, const BitmapTextManager::GlyphMap& font, float scale,
-								   const BitmapTextManager::Textbox& textbox) noexcept
+const tre::BitmapTextManager::CompiledGlyph& tre::BitmapTextManager::Font::glyph(std::uint32_t codepoint) const noexcept
 {
-	const float textboxLeft{textbox.pos.x - textbox.posAnchor.x};
-	const auto  lineWidth{[](std::string_view line, const BitmapTextManager::GlyphMap& font, float scale) {
-        float width{};
-        for (auto it = line.begin(); it != line.end(); ++it) {
-            if (*it == '\\') {
-                if (++it != line.end() && *it == '\\') {
-                    width += font.at(font.contains('\\') ? '\\' : '\0').advance * scale;
-                }
-            }
-            else {
-                width += font.at(font.contains(*it) ? *it : '\0').advance;
-            }
-        }
-        return width;
-    }};
-
-	switch (HorizontalAlign(textbox.textAlignment)) {
-	case HorizontalAlign::LEFT:
-		return textboxLeft;
-	case HorizontalAlign::CENTER:
-		return (textboxLeft + lineWidth(line, font, scale)) / 2.0f;
-	case HorizontalAlign::RIGHT:
-		return textboxLeft + lineWidth(line, font, scale);
+	if (codepoint < DENSE_GLYPHS) {
+		return _denseGlyphs[codepoint];
 	}
+	const auto it{_sparseGlyphs.find(codepoint)};
+	return it != _sparseGlyphs.end() ? it->second : _fallbackGlyph;
 }
 
 bool tre::BitmapTextManager::Font::glyphDrawable(std::uint32_t codepoint) const noexcept
 {
-	const auto& glyph{glyphs.at(glyphs.contains(codepoint) ? codepoint : '\0')};
-	return glyph.width != 0 && glyph.height != 0;
+	const CompiledGlyph& compiled{glyph(codepoint)};
+	return compiled.size.x != 0 && compiled.size.y != 0;
 }
 
 tre::BitmapTextManager::BitmapTextManager() noexcept
-	: _atlas{{256, 256}} // Pre-allocate to make texture() always usable.
+	: _atlas{std::in_place, glm::ivec2{256, 256}} // Pre-allocate to make texture() always usable.
+	, _workerPool{std::make_unique<WorkerPool>()}
 {
 	assert(!bitmapTextActive());
 
 #ifndef NDEBUG
-	_atlas.setLabel("(tre) Bitmap Text Renderer Atlas");
+	_atlas->setLabel("(tre) Bitmap Text Renderer Atlas");
 #endif
 
 	_bitmapText = this;
 }
 
+tre::BitmapTextManager::BitmapTextManager(NullGraphics) noexcept
+	: _workerPool{std::make_unique<WorkerPool>()}
+{
+	assert(!bitmapTextActive());
+	_bitmapText = this;
+}
+
 tre::BitmapTextManager::BitmapTextManager(BitmapTextManager&& r) noexcept
 	: _atlas{std::move(r._atlas)}
 	, _fonts{std::move(r._fonts)}
+	, _glyphTable{std::move(r._glyphTable)}
+	, _glyphTableGeneration{r._glyphTableGeneration}
 	, _cachedRotationTransform{std::move(r._cachedRotationTransform)}
+	, _layout{std::move(r._layout)}
+	, _meshCache{std::move(r._meshCache)}
+	, _workerPool{std::move(r._workerPool)}
 {
 	if (_bitmapText == &r) {
 		_bitmapText = this;
@@ -204,7 +197,8 @@ tre::BitmapTextManager::~BitmapTextManager() noexcept
 
 const tr::Texture2D& tre::BitmapTextManager::texture() const noexcept
 {
-	return _atlas.texture();
+	assert(!nullGraphics());
+	return _atlas->texture();
 }
 
 const tre::BitmapTextManager::Font& tre::BitmapTextManager::font(std::string_view name) const noexcept
@@ -215,9 +209,23 @@ const tre::BitmapTextManager::Font& tre::BitmapTextManager::font(std::string_vie
 
 void tre::BitmapTextManager::addFont(std::string name, tr::SubBitmap texture, std::int32_t lineSkip, GlyphMap glyphs)
 {
+	assert(glyphs.contains('\0'));
+
 	if (!_fonts.contains(name)) {
-		_atlas.add(name, texture);
-		_fonts.emplace(std::move(name), Font{lineSkip, std::move(glyphs)});
+		const glm::ivec2 oldAtlasSize{nullGraphics() ? glm::ivec2{} : _atlas->texture().size()};
+		if (!nullGraphics()) {
+			_atlas->add(name, texture);
+		}
+		Font& font{_fonts.emplace(std::move(name), Font{}).first->second};
+		font.lineSkip = lineSkip;
+		font.glyphs   = std::move(glyphs);
+
+		// Every font is recompiled to keep the glyph table contiguous. The compiled UVs are normalized, so cached
+		// meshes are also stale if the atlas grew.
+		compileFonts();
+		if (!nullGraphics() && _atlas->texture().size() != oldAtlasSize) {
+			clearMeshCache();
+		}
 	}
 }
 
@@ -235,43 +243,97 @@ void tre::BitmapTextManager::removeFont(std::string_view name)
 {
 	auto it{_fonts.find(name)};
 	if (it != _fonts.end()) {
-		_atlas.remove(name);
+		if (!nullGraphics()) {
+			_atlas->remove(name);
+		}
 		_fonts.erase(it);
+		compileFonts();
+		clearMeshCache();
 	}
 }
 
 void tre::BitmapTextManager::clearFonts()
 {
-	_atlas.clear();
+	if (!nullGraphics()) {
+		_atlas->clear();
+	}
 	_fonts.clear();
+	_glyphTable.clear();
+	++_glyphTableGeneration;
+	clearMeshCache();
 }
 
-tre::BitmapTextManager::GlyphMesh tre::BitmapTextManager::createGlyphMesh(std::uint32_t codepoint, const Font& font,
-																		  tr::RectF2 fontUV, Style style,
-																		  glm::vec2 scale, tr::RGBA8 tint,
-																		  glm::vec2 pos, glm::vec2 posAnchor,
-																		  tr::AngleF rotation)
+std::span<const tre::BitmapTextManager::CompiledGlyph> tre::BitmapTextManager::glyphTable() const noexcept
 {
-	assert(font.glyphDrawable(codepoint));
+	return _glyphTable;
+}
 
-	const auto&      glyph{font.glyphs.at(font.glyphs.contains(codepoint) ? codepoint : '\0')};
-	const auto       size{glm::vec2(glyph.width, glyph.height) * scale};
-	const tr::RectF2 uv{fontUV.tl + glm::vec2(glyph.x, glyph.y) / glm::vec2(_atlas.texture().size()),
-						glm::vec2(glyph.width, glyph.height) / glm::vec2(_atlas.texture().size())};
-	const auto       offset{glm::vec2(glyph.xOffset, glyph.yOffset) * scale};
+std::size_t tre::BitmapTextManager::glyphTableGeneration() const noexcept
+{
+	return _glyphTableGeneration;
+}
+
+bool tre::BitmapTextManager::nullGraphics() const noexcept
+{
+	return !_atlas.has_value();
+}
+
+void tre::BitmapTextManager::compileFont(std::string_view name, Font& font)
+{
+	const tr::RectF2 fontUV{nullGraphics() ? tr::RectF2{} : (*_atlas)[name]};
+	const glm::vec2  atlasSize{nullGraphics() ? glm::ivec2{1} : _atlas->texture().size()};
+	const auto       compile{[&](const Glyph& glyph) {
+        const tr::RectF2 uv{nullGraphics() ? tr::RectF2{}
+                                           : tr::RectF2{fontUV.tl + glm::vec2(glyph.x, glyph.y) / atlasSize,
+                                                        glm::vec2(glyph.width, glyph.height) / atlasSize}};
+        _glyphTable.push_back({{glyph.xOffset, glyph.yOffset},
+                               {glyph.width, glyph.height},
+                               uv,
+                               float(glyph.advance),
+                               std::uint32_t(_glyphTable.size())});
+        return _glyphTable.back();
+    }};
 
-	Renderer2D::TextureQuad quad;
-	if (rotation == 0_degf) {
-		tr::fillRectVertices((quad | tr::positions).begin(), pos - posAnchor + offset, size);
+	font._fallbackGlyph = compile(font.glyphs.at('\0'));
+	font._denseGlyphs.fill(font._fallbackGlyph);
+	font._sparseGlyphs.clear();
+	for (const auto& [codepoint, glyph] : font.glyphs) {
+		// The fallback glyph was already compiled and is in the dense table.
+		if (codepoint == '\0') {
+			continue;
+		}
+		if (codepoint < Font::DENSE_GLYPHS) {
+			font._denseGlyphs[codepoint] = compile(glyph);
+		}
+		else {
+			font._sparseGlyphs.emplace(codepoint, compile(glyph));
+		}
+	}
+}
+
+void tre::BitmapTextManager::compileFonts()
+{
+	_glyphTable.clear();
+	for (auto& [name, font] : _fonts) {
+		compileFont(name, font);
+	}
+	++_glyphTableGeneration;
+}
+
+void tre::BitmapTextManager::writeGlyphMesh(std::span<tr::TintVtx2, 4> quad, const CompiledGlyph& glyph, Style style,
+											glm::vec2 scale, tr::RGBA8 tint, glm::vec2 pen,
+											const glm::mat4* transform) noexcept
+{
+	assert(glyph.size.x != 0 && glyph.size.y != 0);
+
+	const auto size{glyph.size * scale};
+	const auto offset{glyph.offset * scale};
+
+	if (transform == nullptr) {
+		tr::fillRectVertices((quad | tr::positions).begin(), pen + offset, size);
 	}
 	else {
-		if (pos != _cachedRotationTransform.pos || rotation != _cachedRotationTransform.rotation) {
-			_cachedRotationTransform.pos       = pos;
-			_cachedRotationTransform.rotation  = rotation;
-			_cachedRotationTransform.transform = tr::rotateAroundPoint2(glm::mat4{1}, pos, rotation);
-		}
-		tr::fillRectVertices((quad | tr::positions).begin(), pos - posAnchor + offset, size,
-							 _cachedRotationTransform.transform);
+		tr::fillRectVertices((quad | tr::positions).begin(), pen + offset, size, *transform);
 	}
 	if (style == Style::ITALIC) {
 		constexpr double TAN_12_5_DEG{0.22169466264};
@@ -279,9 +341,8 @@ tre::BitmapTextManager::GlyphMesh tre::BitmapTextManager::createGlyphMesh(std::u
 		quad[0].pos.x += skewOffset;
 		quad[3].pos.x += skewOffset;
 	}
-	tr::fillRectVertices((quad | tr::uvs).begin(), uv.tl, uv.size);
+	tr::fillRectVertices((quad | tr::uvs).begin(), glyph.uv.tl, glyph.uv.size);
 	std::ranges::fill(quad | tr::colors, tint);
-	return quad;
 }
 
 tre::BitmapTextManager::GlyphMesh tre::BitmapTextManager::createGlyphMesh(std::uint32_t    codepoint,
@@ -291,107 +352,830 @@ tre::BitmapTextManager::GlyphMesh tre::BitmapTextManager::createGlyphMesh(std::u
 																		  tr::AngleF rotation)
 {
 	assert(_fonts.contains(font));
-	return createGlyphMesh(codepoint, _fonts.find(font)->second, _atlas[font], style, scale, tint, pos, posAnchor,
-						   rotation);
+	const glm::mat4* transform{nullptr};
+	if (rotation != 0_degf) {
+		if (pos != _cachedRotationTransform.pos || rotation != _cachedRotationTransform.rotation) {
+			_cachedRotationTransform.pos       = pos;
+			_cachedRotationTransform.rotation  = rotation;
+			_cachedRotationTransform.transform = tr::rotateAroundPoint2(glm::mat4{1}, pos, rotation);
+		}
+		transform = &_cachedRotationTransform.transform;
+	}
+
+	GlyphMesh quad;
+	writeGlyphMesh(quad, _fonts.find(font)->second.glyph(codepoint), style, scale, tint, pos - posAnchor, transform);
+	return quad;
 }
 
-tre::BitmapTextManager::Mesh tre::BitmapTextManager::createUnformattedTextMesh(std::string_view text,
-																			   std::string_view font, Style style,
-																			   glm::vec2 scale, tr::RGBA8 tint,
-																			   const Textbox& textbox)
+void tre::BitmapTextManager::Layout::decodeUnformatted(std::string_view text, const Font& font, Style style,
+													   tr::RGBA8 tint)
 {
-	assert(_fonts.contains(font));
-	const auto fontIt{_fonts.find(font)};
-	const auto fontUV{_atlas[font]};
-
-	Mesh       mesh;
-	const auto lines{splitText(text, fontIt->second.glyphs, scale.x, textbox.size.x, false)};
-	auto       yOffset{initialOffsetY(lines, fontIt->second.lineSkip, textbox)};
-	for (auto& line : lines) {
-		auto xOffset{initialUnformattedOffsetX(line, fontIt->second.glyphs, scale.x, textbox)};
-		for (auto chr : tr::utf8Range(line)) {
-			if (!fontIt->second.glyphs.contains(chr)) {
-				chr = '\0';
+	glyphs.clear();
+	appendUnformatted(text, font, style, tint);
+}
+
+void tre::BitmapTextManager::Layout::decodeFormatted(std::string_view text, const Font& font,
+													 std::span<const tr::RGBA8> colors)
+{
+	FormatState state;
+	glyphs.clear();
+	appendFormatted(text, font, colors, state);
+}
+
+void tre::BitmapTextManager::Layout::decodeRich(const RichText& text, const Font& font,
+												std::span<const tr::RGBA8> colors)
+{
+	FormatState state;
+	glyphs.clear();
+	appendRich(text, font, colors, state);
+}
+
+void tre::BitmapTextManager::Layout::appendRich(const RichText& text, const Font& font,
+												std::span<const tr::RGBA8> colors, FormatState& state)
+{
+	auto& [style, tint]{state};
+	for (const RichText::Run& run : text.runs()) {
+		if (run.color == RichText::DEFAULT_COLOR) {
+			tint = {255, 255, 255, 255};
+		}
+		else if (run.color < colors.size()) {
+			tint = colors[run.color];
+		}
+		style = run.italic ? Style::ITALIC : Style::NORMAL;
+		appendUnformatted(text.text(run), font, style, tint);
+	}
+}
+
+void tre::BitmapTextManager::Layout::appendGlyph(std::uint32_t codepoint, const Font& font, Style style,
+												 tr::RGBA8 tint)
+{
+	LayoutGlyph::Kind kind{LayoutGlyph::Kind::GLYPH};
+	if (codepoint == '\n') {
+		kind = LayoutGlyph::Kind::NEWLINE;
+	}
+	else if (codepoint == ' ' || codepoint == '\t') {
+		kind = LayoutGlyph::Kind::BREAKABLE;
+	}
+	glyphs.push_back({&font.glyph(codepoint), tint, style, kind});
+}
+
+void tre::BitmapTextManager::Layout::appendUnformatted(std::string_view text, const Font& font, Style style,
+													   tr::RGBA8 tint)
+{
+	appendPlain(text, font, style, tint, false);
+}
+
+std::size_t tre::BitmapTextManager::Layout::appendPlain(std::string_view text, const Font& font, Style style,
+														tr::RGBA8 tint, bool formatted)
+{
+	std::size_t length{0};
+	while (length < text.size()) {
+		// Runs of plain ASCII characters are found several bytes at a time and indexed directly, while the characters
+		// ending them are classified or decoded as UTF-8 one at a time.
+		const std::size_t plain{plainAsciiPrefixLength(text.substr(length), formatted)};
+		for (char chr : text.substr(length, plain)) {
+			glyphs.push_back({&font.glyph(chr), tint, style, LayoutGlyph::Kind::GLYPH});
+		}
+		length += plain;
+		if (length == text.size() || (formatted && text[length] == '\\')) {
+			break;
+		}
+
+		if ((text[length] & 0x80) == 0) {
+			appendGlyph(text[length++], font, style, tint);
+		}
+		else {
+			const std::size_t nonAscii{nonAsciiPrefixLength(text.substr(length))};
+			for (std::uint32_t codepoint : tr::utf8Range(text.substr(length, nonAscii))) {
+				appendGlyph(codepoint, font, style, tint);
 			}
-			if (fontIt->second.glyphDrawable(chr)) {
-				const auto glyphMesh{createGlyphMesh(chr, fontIt->second, fontUV, style, scale, tint, textbox.pos,
-													 textbox.pos - glm::vec2(xOffset, yOffset), textbox.rotation)};
-				tr::fillPolygonIndices(std::back_inserter(mesh.indices), 4, mesh.vertices.size());
-				mesh.vertices.insert(mesh.vertices.end(), glyphMesh.begin(), glyphMesh.end());
+			length += nonAscii;
+		}
+	}
+	return length;
+}
+
+std::string_view tre::BitmapTextManager::Layout::appendFormatted(std::string_view text, const Font& font,
+																 std::span<const tr::RGBA8> colors, FormatState& state)
+{
+	auto& [style, tint]{state};
+	while (!text.empty()) {
+		// The text between escape sequences is appended like unformatted text.
+		text.remove_prefix(appendPlain(text, font, style, tint, true));
+		if (text.empty()) {
+			break;
+		}
+
+		text.remove_prefix(1);
+		if (text.empty()) {
+			return "\\";
+		}
+		const char escape{text[0]};
+		removeCharacter(text);
+		switch (escape) {
+		case '\\':
+			glyphs.push_back({&font.glyph('\\'), tint, style, LayoutGlyph::Kind::GLYPH});
+			break;
+		case '!':
+			tint = {255, 255, 255, 255};
+			break;
+		case 'c':
+			if (text.empty()) {
+				return "\\c";
+			}
+			if (text[0] >= '0' && text[0] <= '9' && std::size_t(text[0] - '0') < colors.size()) {
+				tint = colors[text[0] - '0'];
+			}
+			removeCharacter(text);
+			break;
+		case 'i':
+			style = style == Style::NORMAL ? Style::ITALIC : Style::NORMAL;
+			break;
+		default:
+			break;
+		}
+	}
+	return {};
+}
+
+void tre::BitmapTextManager::Layout::breakLines(float scale, float maxWidth, std::size_t firstLine)
+{
+	assert(firstLine == 0 || firstLine < lines.size());
+
+	std::size_t lineBegin{firstLine != 0 ? lines[firstLine].begin : 0};
+	float       width{0};
+	// The last breakable glyph of the current line and the width of the line before it.
+	std::optional<std::size_t> lastBreakable;
+	float                      widthBeforeBreakable{0};
+	lines.erase(lines.begin() + firstLine, lines.end());
+	for (std::size_t i = lineBegin; i < glyphs.size();) {
+		if (glyphs[i].kind == LayoutGlyph::Kind::NEWLINE) {
+			lines.push_back({lineBegin, i, width});
+			lineBegin = ++i;
+			width     = 0;
+			lastBreakable.reset();
+			continue;
+		}
+
+		const float advance{glyphs[i].glyph->advance * scale};
+		if (i != lineBegin && width + advance > maxWidth) {
+			if (glyphs[i].kind == LayoutGlyph::Kind::BREAKABLE) {
+				// The overflowing whitespace is swallowed by the line break.
+				lines.push_back({lineBegin, i, width});
+				lineBegin = ++i;
+			}
+			else if (lastBreakable.has_value()) {
+				// The glyphs after the last breakable glyph are measured again from the start of the next line.
+				lines.push_back({lineBegin, *lastBreakable, widthBeforeBreakable});
+				lineBegin = i = *lastBreakable + 1;
+			}
+			else {
+				lines.push_back({lineBegin, i, width});
+				lineBegin = i;
+			}
+			width = 0;
+			lastBreakable.reset();
+			continue;
+		}
+
+		if (glyphs[i].kind == LayoutGlyph::Kind::BREAKABLE) {
+			lastBreakable        = i;
+			widthBeforeBreakable = width;
+		}
+		width += advance;
+		++i;
+	}
+	lines.push_back({lineBegin, glyphs.size(), width});
+}
+
+std::size_t tre::BitmapTextManager::Layout::quadCount() const noexcept
+{
+	std::size_t count{0};
+	for (const LayoutLine& line : lines) {
+		for (std::size_t i = line.begin; i < line.end; ++i) {
+			const CompiledGlyph& glyph{*glyphs[i].glyph};
+			count += glyph.size.x != 0 && glyph.size.y != 0;
+		}
+	}
+	return count;
+}
+
+template <class Fn>
+void tre::BitmapTextManager::Layout::forEachQuad(glm::vec2 scale, float lineSkip, const Textbox& textbox, Fn fn,
+												 std::size_t firstLine) const
+{
+	float yOffset{initialOffsetY(lines.size(), lineSkip * scale.y, textbox) + firstLine * lineSkip * scale.y};
+	for (const LayoutLine& line : std::span{lines}.subspan(firstLine)) {
+		float xOffset{initialOffsetX(line.width, textbox)};
+		for (std::size_t i = line.begin; i < line.end; ++i) {
+			const LayoutGlyph& glyph{glyphs[i]};
+			if (glyph.glyph->size.x != 0 && glyph.glyph->size.y != 0) {
+				fn(glyph, glm::vec2{xOffset, yOffset});
 			}
-			xOffset += fontIt->second.glyphs.at(chr).advance * scale.x;
+			xOffset += glyph.glyph->advance * scale.x;
 		}
-		yOffset += fontIt->second.lineSkip * scale.y;
+		yOffset += lineSkip * scale.y;
 	}
+}
+
+void tre::BitmapTextManager::Layout::writeMesh(std::span<tr::TintVtx2> vertices, std::span<std::uint16_t> indices,
+											   glm::vec2 scale, float lineSkip, const Textbox& textbox) const
+{
+	const std::optional<glm::mat4> transform{textboxTransform(textbox)};
+	std::size_t                    quad{0};
+	forEachQuad(scale, lineSkip, textbox, [&](const LayoutGlyph& glyph, glm::vec2 pen) {
+		writeGlyphMesh(vertices.subspan(quad * 4).first<4>(), *glyph.glyph, glyph.style, scale, glyph.tint, pen,
+					   transform.has_value() ? &*transform : nullptr);
+		tr::fillPolygonIndices(indices.begin() + quad * 6, 4, std::uint16_t(quad * 4));
+		++quad;
+	});
+}
+
+tre::BitmapTextManager::Mesh tre::BitmapTextManager::Layout::createMesh(glm::vec2 scale, float lineSkip,
+																		const Textbox& textbox) const
+{
+	const std::size_t quads{quadCount()};
+	Mesh              mesh{std::vector<tr::TintVtx2>(quads * 4), std::vector<std::uint16_t>(quads * 6)};
+	writeMesh(mesh.vertices, mesh.indices, scale, lineSkip, textbox);
 	return mesh;
 }
 
+void tre::BitmapTextManager::Layout::writeQuads(std::span<GlyphMesh> quads, glm::vec2 scale, float lineSkip,
+												const Textbox& textbox) const
+{
+	const std::optional<glm::mat4> transform{textboxTransform(textbox)};
+	std::size_t                    quad{0};
+	forEachQuad(scale, lineSkip, textbox, [&](const LayoutGlyph& glyph, glm::vec2 pen) {
+		if (quad < quads.size()) {
+			writeGlyphMesh(quads[quad], *glyph.glyph, glyph.style, scale, glyph.tint, pen,
+						   transform.has_value() ? &*transform : nullptr);
+		}
+		++quad;
+	});
+}
+
+void tre::BitmapTextManager::Layout::addToLayer(int layer, glm::vec2 scale, float lineSkip,
+												const Textbox& textbox) const
+{
+	const std::optional<glm::mat4> transform{textboxTransform(textbox)};
+	Renderer2D&                    renderer{renderer2D()};
+	std::size_t                    quadsLeft{quadCount()};
+	std::size_t                    quad{0};
+	std::size_t                    meshQuads{0};
+	Renderer2D::TextureMeshSpans   mesh;
+	forEachQuad(scale, lineSkip, textbox, [&](const LayoutGlyph& glyph, glm::vec2 pen) {
+		// Text that doesn't fit in one mesh is split into several.
+		if (quad == meshQuads) {
+			meshQuads = std::min(quadsLeft, MAX_TEXT_MESH_QUADS);
+			mesh      = renderer.allocateTextureMesh(layer, meshQuads * 4, meshQuads * 6);
+			quadsLeft -= meshQuads;
+			quad = 0;
+		}
+		writeGlyphMesh(mesh.vertices.subspan(quad * 4).first<4>(), *glyph.glyph, glyph.style, scale, glyph.tint, pen,
+					   transform.has_value() ? &*transform : nullptr);
+		tr::fillPolygonIndices(mesh.indices.begin() + quad * 6, 4, std::uint16_t(quad * 4));
+		++quad;
+	});
+}
+
+void tre::BitmapTextManager::Layout::appendInstances(std::vector<GlyphInstance>& instances, glm::vec2 scale,
+													 float lineSkip, const Textbox& textbox) const
+{
+	const glm::vec2     rotation{std::cos(textbox.rotation.rads()), std::sin(textbox.rotation.rads())};
+	const std::uint32_t packedScale{glm::packHalf2x16(scale)};
+	const std::uint32_t packedRotation{glm::packSnorm2x16(rotation)};
+
+	instances.reserve(instances.size() + quadCount());
+	forEachQuad(scale, lineSkip, textbox, [&](const LayoutGlyph& glyph, glm::vec2 pen) {
+		const glm::vec2 offset{pen - textbox.pos};
+		const glm::vec2 rotatedPen{textbox.pos + glm::vec2{offset.x * rotation.x - offset.y * rotation.y,
+														   offset.x * rotation.y + offset.y * rotation.x}};
+		const std::uint32_t italic{glyph.style == Style::ITALIC ? ITALIC_GLYPH_INSTANCE : 0};
+		instances.push_back({rotatedPen, packedScale, packedRotation, glyph.glyph->index | italic, glyph.tint});
+	});
+}
+
+tre::TextMetrics tre::BitmapTextManager::Layout::measure(std::span<float> lineWidths, glm::vec2 scale,
+														  float lineSkip) const noexcept
+{
+	float width{0};
+	for (std::size_t i = 0; i < lines.size(); ++i) {
+		if (i < lineWidths.size()) {
+			lineWidths[i] = lines[i].width;
+		}
+		width = std::max(width, lines[i].width);
+	}
+	return {lines.size(), {width, lines.size() * lineSkip * scale.y}};
+}
+
+const tre::BitmapTextManager::Font& tre::BitmapTextManager::layoutUnformatted(Layout& layout, std::string_view text,
+																			  std::string_view font, Style style,
+																			  float scale, tr::RGBA8 tint,
+																			  float maxWidth) const
+{
+	assert(_fonts.contains(font));
+	const Font& fontInfo{_fonts.find(font)->second};
+	layout.decodeUnformatted(text, fontInfo, style, tint);
+	layout.breakLines(scale, maxWidth);
+	return fontInfo;
+}
+
+const tre::BitmapTextManager::Font& tre::BitmapTextManager::layoutFormatted(Layout& layout, std::string_view text,
+																			std::string_view font, float scale,
+																			std::span<const tr::RGBA8> colors,
+																			float                      maxWidth) const
+{
+	assert(_fonts.contains(font));
+	const Font& fontInfo{_fonts.find(font)->second};
+	layout.decodeFormatted(text, fontInfo, colors);
+	layout.breakLines(scale, maxWidth);
+	return fontInfo;
+}
+
+const tre::BitmapTextManager::Font& tre::BitmapTextManager::layoutRich(Layout& layout, const RichText& text,
+																	   std::string_view font, float scale,
+																	   std::span<const tr::RGBA8> colors,
+																	   float                      maxWidth) const
+{
+	assert(_fonts.contains(font));
+	const Font& fontInfo{_fonts.find(font)->second};
+	layout.decodeRich(text, fontInfo, colors);
+	layout.breakLines(scale, maxWidth);
+	return fontInfo;
+}
+
+tre::BitmapTextManager::Mesh tre::BitmapTextManager::createUnformattedTextMesh(std::string_view text,
+																			   std::string_view font, Style style,
+																			   glm::vec2 scale, tr::RGBA8 tint,
+																			   const Textbox& textbox)
+{
+	const Font& fontInfo{layoutUnformatted(_layout, text, font, style, scale.x, tint, textbox.size.x)};
+	return _layout.createMesh(scale, float(fontInfo.lineSkip), textbox);
+}
+
 tre::BitmapTextManager::Mesh tre::BitmapTextManager::createFormattedTextMesh(std::string_view text,
 																			 std::string_view font, glm::vec2 scale,
 																			 std::span<tr::RGBA8> colors,
 																			 const Textbox&       textbox)
+{
+	const Font& fontInfo{layoutFormatted(_layout, text, font, scale.x, colors, textbox.size.x)};
+	return _layout.createMesh(scale, float(fontInfo.lineSkip), textbox);
+}
+
+tre::BitmapTextManager::LaidOutText tre::BitmapTextManager::layOutUnformattedText(std::string_view text,
+																				 std::string_view font, Style style,
+																				 glm::vec2 scale, tr::RGBA8 tint,
+																				 const Textbox& textbox) const
 {
 	assert(_fonts.contains(font));
-	const auto fontIt{_fonts.find(font)};
-	const auto fontUV{_atlas[font]};
-
-	Mesh       mesh;
-	const auto lines{splitText(text, fontIt->second.glyphs, scale.x, textbox.size.x, true)};
-	auto       yOffset{initialOffsetY(lines, fontIt->second.lineSkip, textbox)};
-	Style      style{Style::NORMAL};
-	tr::RGBA8  tint{255, 255, 255, 255};
-	for (auto& line : lines) {
-		auto xOffset{initialFormattedOffsetX(line, fontIt->second.glyphs, scale.x, textbox)};
-		for (auto it = line.begin(); it != line.end(); ++it) {
-			if (*it == '\\') {
-				if (++it == line.end()) {
-					goto line_end;
-				}
-				switch (*it) {
-				case '\\': {
-					const auto chr{fontIt->second.glyphs.contains('\\') ? '\\' : '\0'};
-					if (fontIt->second.glyphDrawable(chr)) {
-						const auto glyphMesh{createGlyphMesh(chr, fontIt->second, fontUV, style, scale, tint,
-															 textbox.pos, textbox.pos - glm::vec2(xOffset, yOffset),
-															 textbox.rotation)};
-						tr::fillPolygonIndices(std::back_inserter(mesh.indices), 4, mesh.vertices.size());
-						mesh.vertices.insert(mesh.vertices.end(), glyphMesh.begin(), glyphMesh.end());
-					}
-					xOffset += fontIt->second.glyphs.at(chr).advance * scale.x;
-				} break;
-				case '!':
-					tint = {255, 255, 255, 255};
-					break;
-				case 'c':
-					if (++it == text.end()) {
-						goto line_end;
-					}
-					if (std::isdigit(*it) && *it - '0' < colors.size()) {
-						tint = colors[*it - '0'];
-					}
-					break;
-				case 'i':
-					style = style == Style::NORMAL ? Style::ITALIC : Style::NORMAL;
-					break;
-				default:
-					break;
-				}
-			}
-			else {
-				const auto chr{fontIt->second.glyphs.contains(*it) ? *it : '\0'};
-				if (fontIt->second.glyphDrawable(chr)) {
-					const auto glyphMesh{createGlyphMesh(chr, fontIt->second, fontUV, style, scale, tint, textbox.pos,
-														 textbox.pos - glm::vec2(xOffset, yOffset), textbox.rotation)};
-					tr::fillPolygonIndices(std::back_inserter(mesh.indices), 4, mesh.vertices.size());
-					mesh.vertices.insert(mesh.vertices.end(), glyphMesh.begin(), glyphMesh.end());
-				}
-				xOffset += fontIt->second.glyphs.at(chr).advance * scale.x;
-			}
+	LaidOutText laidOut{_fonts.find(font)->second, false, {}, {style, tint}, scale, textbox};
+	laidOut.append(text);
+	return laidOut;
+}
+
+tre::BitmapTextManager::LaidOutText tre::BitmapTextManager::layOutFormattedText(std::string_view text,
+																			   std::string_view font, glm::vec2 scale,
+																			   std::span<const tr::RGBA8> colors,
+																			   const Textbox&             textbox) const
+{
+	assert(_fonts.contains(font));
+	LaidOutText laidOut{_fonts.find(font)->second, true, colors, {}, scale, textbox};
+	laidOut.append(text);
+	return laidOut;
+}
+
+tre::BitmapTextManager::LaidOutText tre::BitmapTextManager::layOutFormattedText(const RichText& text,
+																			   std::string_view font, glm::vec2 scale,
+																			   std::span<const tr::RGBA8> colors,
+																			   const Textbox&             textbox) const
+{
+	assert(_fonts.contains(font));
+	LaidOutText laidOut{_fonts.find(font)->second, true, colors, {}, scale, textbox};
+	laidOut.append(text);
+	return laidOut;
+}
+
+tre::BitmapTextManager::Mesh tre::BitmapTextManager::createFormattedTextMesh(const RichText& text,
+																			 std::string_view font, glm::vec2 scale,
+																			 std::span<tr::RGBA8> colors,
+																			 const Textbox&       textbox)
+{
+	const Font& fontInfo{layoutRich(_layout, text, font, scale.x, colors, textbox.size.x)};
+	return _layout.createMesh(scale, float(fontInfo.lineSkip), textbox);
+}
+
+std::vector<tre::BitmapTextManager::Mesh> tre::BitmapTextManager::createTextMeshes(
+	std::span<const TextRequest> requests, unsigned int threads) const
+{
+	assert(threads > 0);
+
+	std::vector<Mesh> meshes(requests.size());
+	const std::size_t perThread{std::max((requests.size() + threads - 1) / threads, MIN_TEXT_REQUESTS_PER_THREAD)};
+	const std::size_t ranges{(requests.size() + perThread - 1) / perThread};
+	// Exceptions can't propagate out of the worker threads, so they are stored and rethrown afterwards.
+	std::vector<std::exception_ptr> errors(ranges);
+	const auto                      createRange{[&](std::size_t range) {
+        try {
+            Layout layout;
+            for (std::size_t i = range * perThread; i < std::min((range + 1) * perThread, requests.size()); ++i) {
+                const TextRequest& request{requests[i]};
+                const Font&        font{request.richText != nullptr
+                                            ? layoutRich(layout, *request.richText, request.font, request.scale.x,
+                                                         request.colors, request.textbox.size.x)
+                                        : request.formatted
+                                            ? layoutFormatted(layout, request.text, request.font, request.scale.x,
+                                                              request.colors, request.textbox.size.x)
+                                            : layoutUnformatted(layout, request.text, request.font, request.style,
+                                                                request.scale.x, request.tint, request.textbox.size.x)};
+                meshes[i] = layout.createMesh(request.scale, float(font.lineSkip), request.textbox);
+            }
+        }
+        catch (...) {
+            errors[range] = std::current_exception();
+        }
+    }};
+
+	if (ranges > 1) {
+		std::latch                         done{std::ptrdiff_t(ranges - 1)};
+		std::vector<std::function<void()>> jobs;
+		jobs.reserve(ranges - 1);
+		for (std::size_t range = 1; range < ranges; ++range) {
+			jobs.emplace_back([&, range] {
+				createRange(range);
+				done.count_down();
+			});
 		}
-	line_end:
-		yOffset += fontIt->second.lineSkip * scale.y;
+		_workerPool->reserve(ranges - 1);
+		_workerPool->run(jobs);
+		createRange(0);
+		done.wait();
 	}
-	return mesh;
+	else if (ranges == 1) {
+		createRange(0);
+	}
+	for (const std::exception_ptr& error : errors) {
+		if (error != nullptr) {
+			std::rethrow_exception(error);
+		}
+	}
+	return meshes;
+}
+
+void tre::BitmapTextManager::WorkerPool::reserve(std::size_t workers)
+{
+	std::lock_guard lock{_mutex};
+	while (_workers.size() < workers) {
+		_workers.emplace_back([this](std::stop_token stop) { work(stop); });
+	}
+}
+
+void tre::BitmapTextManager::WorkerPool::run(std::span<std::function<void()>> jobs)
+{
+	{
+		std::lock_guard lock{_mutex};
+		const std::size_t queued{_jobs.size()};
+		try {
+			std::ranges::move(jobs, std::back_inserter(_jobs));
+		}
+		catch (...) {
+			_jobs.resize(queued);
+			throw;
+		}
+	}
+	_jobQueued.notify_all();
+}
+
+void tre::BitmapTextManager::WorkerPool::work(std::stop_token stop)
+{
+	std::unique_lock lock{_mutex};
+	while (_jobQueued.wait(lock, stop, [&] { return !_jobs.empty(); })) {
+		const std::function<void()> job{std::move(_jobs.front())};
+		_jobs.pop_front();
+		lock.unlock();
+		job();
+		lock.lock();
+	}
+}
+
+void tre::BitmapTextManager::addUnformattedText(int layer, std::string_view text, std::string_view font, Style style,
+												glm::vec2 scale, tr::RGBA8 tint, const Textbox& textbox)
+{
+	const Font& fontInfo{layoutUnformatted(_layout, text, font, style, scale.x, tint, textbox.size.x)};
+	_layout.addToLayer(layer, scale, float(fontInfo.lineSkip), textbox);
+}
+
+void tre::BitmapTextManager::addFormattedText(int layer, std::string_view text, std::string_view font,
+											  glm::vec2 scale, std::span<tr::RGBA8> colors, const Textbox& textbox)
+{
+	const Font& fontInfo{layoutFormatted(_layout, text, font, scale.x, colors, textbox.size.x)};
+	_layout.addToLayer(layer, scale, float(fontInfo.lineSkip), textbox);
+}
+
+void tre::BitmapTextManager::addFormattedText(int layer, const RichText& text, std::string_view font,
+											  glm::vec2 scale, std::span<tr::RGBA8> colors, const Textbox& textbox)
+{
+	const Font& fontInfo{layoutRich(_layout, text, font, scale.x, colors, textbox.size.x)};
+	_layout.addToLayer(layer, scale, float(fontInfo.lineSkip), textbox);
+}
+
+std::size_t tre::BitmapTextManager::writeUnformattedTextQuads(std::span<GlyphMesh> quads, std::string_view text,
+															  std::string_view font, Style style, glm::vec2 scale,
+															  tr::RGBA8 tint, const Textbox& textbox)
+{
+	const Font& fontInfo{layoutUnformatted(_layout, text, font, style, scale.x, tint, textbox.size.x)};
+	_layout.writeQuads(quads, scale, float(fontInfo.lineSkip), textbox);
+	return _layout.quadCount();
+}
+
+std::size_t tre::BitmapTextManager::writeFormattedTextQuads(std::span<GlyphMesh> quads, std::string_view text,
+															std::string_view font, glm::vec2 scale,
+															std::span<tr::RGBA8> colors, const Textbox& textbox)
+{
+	const Font& fontInfo{layoutFormatted(_layout, text, font, scale.x, colors, textbox.size.x)};
+	_layout.writeQuads(quads, scale, float(fontInfo.lineSkip), textbox);
+	return _layout.quadCount();
+}
+
+std::size_t tre::BitmapTextManager::writeFormattedTextQuads(std::span<GlyphMesh> quads, const RichText& text,
+															std::string_view font, glm::vec2 scale,
+															std::span<tr::RGBA8> colors, const Textbox& textbox)
+{
+	const Font& fontInfo{layoutRich(_layout, text, font, scale.x, colors, textbox.size.x)};
+	_layout.writeQuads(quads, scale, float(fontInfo.lineSkip), textbox);
+	return _layout.quadCount();
+}
+
+void tre::BitmapTextManager::appendUnformattedTextInstances(std::vector<GlyphInstance>& instances,
+															 std::string_view text, std::string_view font, Style style,
+															 glm::vec2 scale, tr::RGBA8 tint, const Textbox& textbox)
+{
+	const Font& fontInfo{layoutUnformatted(_layout, text, font, style, scale.x, tint, textbox.size.x)};
+	_layout.appendInstances(instances, scale, float(fontInfo.lineSkip), textbox);
+}
+
+void tre::BitmapTextManager::appendFormattedTextInstances(std::vector<GlyphInstance>& instances,
+														   std::string_view text, std::string_view font,
+														   glm::vec2 scale, std::span<tr::RGBA8> colors,
+														   const Textbox& textbox)
+{
+	const Font& fontInfo{layoutFormatted(_layout, text, font, scale.x, colors, textbox.size.x)};
+	_layout.appendInstances(instances, scale, float(fontInfo.lineSkip), textbox);
+}
+
+void tre::BitmapTextManager::appendFormattedTextInstances(std::vector<GlyphInstance>& instances,
+														   const RichText& text, std::string_view font,
+														   glm::vec2 scale, std::span<tr::RGBA8> colors,
+														   const Textbox& textbox)
+{
+	const Font& fontInfo{layoutRich(_layout, text, font, scale.x, colors, textbox.size.x)};
+	_layout.appendInstances(instances, scale, float(fontInfo.lineSkip), textbox);
+}
+
+tre::TextMetrics tre::BitmapTextManager::measureUnformattedText(std::span<float> lineWidths, std::string_view text,
+																std::string_view font, glm::vec2 scale, float maxWidth)
+{
+	const Font& fontInfo{layoutUnformatted(_layout, text, font, Style::NORMAL, scale.x, {}, maxWidth)};
+	return _layout.measure(lineWidths, scale, float(fontInfo.lineSkip));
+}
+
+tre::TextMetrics tre::BitmapTextManager::measureFormattedText(std::span<float> lineWidths, std::string_view text,
+															  std::string_view font, glm::vec2 scale, float maxWidth)
+{
+	const Font& fontInfo{layoutFormatted(_layout, text, font, scale.x, {}, maxWidth)};
+	return _layout.measure(lineWidths, scale, float(fontInfo.lineSkip));
+}
+
+tre::TextMetrics tre::BitmapTextManager::measureFormattedText(std::span<float> lineWidths, const RichText& text,
+															  std::string_view font, glm::vec2 scale, float maxWidth)
+{
+	const Font& fontInfo{layoutRich(_layout, text, font, scale.x, {}, maxWidth)};
+	return _layout.measure(lineWidths, scale, float(fontInfo.lineSkip));
+}
+
+const tre::BitmapTextManager::Mesh& tre::BitmapTextManager::cachedTextMesh(const TextMeshKey& key)
+{
+	const auto hashBytes{[](const void* data, std::size_t size) {
+        return std::hash<std::string_view>{}({static_cast<const char*>(data), size});
+    }};
+	const auto combineHashes{[](std::size_t seed, std::size_t hash) {
+        return seed ^ (hash + 0x9E3779B97F4A7C15 + (seed << 6) + (seed >> 2));
+    }};
+	const Textbox&                    textbox{key.textbox};
+	const std::array<float, 9>        floats{key.scale.x,         key.scale.y,         textbox.pos.x,
+											 textbox.pos.y,       textbox.posAnchor.x, textbox.posAnchor.y,
+											 textbox.size.x,      textbox.size.y,      textbox.rotation.rads()};
+	const std::array<std::uint8_t, 7> flags{key.formatted, std::uint8_t(key.style), key.tint.r, key.tint.g, key.tint.b,
+											key.tint.a,    std::uint8_t(textbox.textAlignment)};
+	const std::span<const RichText::Run> runs{key.richText != nullptr ? key.richText->runs()
+																	  : std::span<const RichText::Run>{}};
+	std::size_t                          hash{std::hash<std::string_view>{}(key.text)};
+	hash = combineHashes(hash, std::hash<std::string_view>{}(key.font));
+	// Runs are only compared on collision, so hashing their count is enough to tell parsed text from unparsed text.
+	hash = combineHashes(hash, runs.size());
+	hash = combineHashes(hash, hashBytes(key.colors.data(), key.colors.size_bytes()));
+	hash = combineHashes(hash, hashBytes(floats.data(), sizeof(floats)));
+	hash = combineHashes(hash, hashBytes(flags.data(), sizeof(flags)));
+
+	const auto [first, last]{_meshCache.index.equal_range(hash)};
+	for (auto it = first; it != last; ++it) {
+		const CachedTextMesh& entry{*it->second};
+		if (entry.text == key.text && entry.font == key.font && entry.formatted == key.formatted &&
+			entry.style == key.style && entry.tint == key.tint && std::ranges::equal(entry.colors, key.colors) &&
+			std::ranges::equal(entry.runs, runs) && entry.scale == key.scale && entry.textbox.pos == textbox.pos &&
+			entry.textbox.posAnchor == textbox.posAnchor && entry.textbox.size == textbox.size &&
+			entry.textbox.rotation == textbox.rotation && entry.textbox.textAlignment == textbox.textAlignment) {
+			_meshCache.entries.splice(_meshCache.entries.begin(), _meshCache.entries, it->second);
+			++_meshCache.counters.hits;
+			return it->second->mesh;
+		}
+	}
+
+	const Font& font{key.richText != nullptr
+						 ? layoutRich(_layout, *key.richText, key.font, key.scale.x, key.colors, textbox.size.x)
+					 : key.formatted
+						 ? layoutFormatted(_layout, key.text, key.font, key.scale.x, key.colors, textbox.size.x)
+						 : layoutUnformatted(_layout, key.text, key.font, key.style, key.scale.x, key.tint,
+											 textbox.size.x)};
+	Mesh        mesh{_layout.createMesh(key.scale, float(font.lineSkip), textbox)};
+
+	const std::size_t bytes{sizeof(CachedTextMesh) + key.text.size() + key.font.size() + key.colors.size_bytes() +
+							runs.size_bytes() + mesh.vertices.size() * sizeof(tr::TintVtx2) +
+							mesh.indices.size() * sizeof(std::uint16_t)};
+	_meshCache.entries.emplace_front(hash, std::string{key.text}, std::string{key.font}, key.formatted, key.style,
+									 key.tint, std::vector<tr::RGBA8>(key.colors.begin(), key.colors.end()),
+									 std::vector<RichText::Run>(runs.begin(), runs.end()), key.scale, textbox,
+									 std::move(mesh), bytes);
+	try {
+		_meshCache.index.emplace(hash, _meshCache.entries.begin());
+	}
+	catch (...) {
+		_meshCache.entries.pop_front();
+		throw;
+	}
+	_meshCache.bytes += bytes;
+	++_meshCache.counters.misses;
+	// The new entry is the most recently used one, so it is never evicted here.
+	trimMeshCache();
+	return _meshCache.entries.front().mesh;
+}
+
+void tre::BitmapTextManager::trimMeshCache() noexcept
+{
+	while (_meshCache.bytes > _meshCache.budget && _meshCache.entries.size() > 1) {
+		const auto lru{std::prev(_meshCache.entries.end())};
+		auto [first, last]{_meshCache.index.equal_range(lru->hash)};
+		_meshCache.index.erase(std::find_if(first, last, [&](auto& pair) { return pair.second == lru; }));
+		_meshCache.bytes -= lru->bytes;
+		_meshCache.entries.erase(lru);
+	}
+}
+
+const tre::BitmapTextManager::Mesh& tre::BitmapTextManager::cachedUnformattedTextMesh(std::string_view text,
+																					  std::string_view font,
+																					  Style style, glm::vec2 scale,
+																					  tr::RGBA8      tint,
+																					  const Textbox& textbox)
+{
+	return cachedTextMesh({text, font, false, style, tint, {}, scale, textbox});
+}
+
+const tre::BitmapTextManager::Mesh& tre::BitmapTextManager::cachedFormattedTextMesh(std::string_view text,
+																					std::string_view font,
+																					glm::vec2        scale,
+																					std::span<tr::RGBA8> colors,
+																					const Textbox&       textbox)
+{
+	return cachedTextMesh({text, font, true, Style::NORMAL, {255, 255, 255, 255}, colors, scale, textbox});
+}
+
+const tre::BitmapTextManager::Mesh& tre::BitmapTextManager::cachedFormattedTextMesh(const RichText& text,
+																					std::string_view font,
+																					glm::vec2        scale,
+																					std::span<tr::RGBA8> colors,
+																					const Textbox&       textbox)
+{
+	return cachedTextMesh(
+		{text.text(), font, true, Style::NORMAL, {255, 255, 255, 255}, colors, scale, textbox, &text});
+}
+
+void tre::BitmapTextManager::setMeshCacheBudget(std::size_t bytes) noexcept
+{
+	_meshCache.budget = bytes;
+	trimMeshCache();
+}
+
+void tre::BitmapTextManager::clearMeshCache() noexcept
+{
+	_meshCache.entries.clear();
+	_meshCache.index.clear();
+	_meshCache.bytes = 0;
+}
+
+const tre::BitmapTextManager::MeshCacheCounters& tre::BitmapTextManager::meshCacheCounters() const noexcept
+{
+	return _meshCache.counters;
+}
+
+void tre::BitmapTextManager::resetMeshCacheCounters() noexcept
+{
+	_meshCache.counters = {};
+}
+
+tre::BitmapTextManager::LaidOutText::LaidOutText(const Font& font, bool formatted, std::span<const tr::RGBA8> colors,
+												 FormatState formatState, glm::vec2 scale, const Textbox& textbox)
+	: _font{&font}
+	, _formatted{formatted}
+	, _colors(colors.begin(), colors.end())
+	, _formatState{formatState}
+	, _scale{scale}
+	, _textbox{textbox}
+	, _quadsBefore{0}
+{
+}
+
+void tre::BitmapTextManager::LaidOutText::append(std::string_view text)
+{
+	// The last line may be broken differently once text is added to it, so it is laid out again.
+	const std::size_t firstLine{_layout.lines.empty() ? 0 : _layout.lines.size() - 1};
+	if (!_formatted) {
+		_layout.appendUnformatted(text, *_font, _formatState.style, _formatState.tint);
+	}
+	else if (_pendingEscape.empty()) {
+		_pendingEscape = _layout.appendFormatted(text, *_font, _colors, _formatState);
+	}
+	else {
+		const std::string joined{_pendingEscape + std::string{text}};
+		_pendingEscape = _layout.appendFormatted(joined, *_font, _colors, _formatState);
+	}
+	layOutAppended(firstLine);
+}
+
+void tre::BitmapTextManager::LaidOutText::append(const RichText& text)
+{
+	assert(_formatted);
+
+	const std::size_t firstLine{_layout.lines.empty() ? 0 : _layout.lines.size() - 1};
+	_layout.appendRich(text, *_font, _colors, _formatState);
+	layOutAppended(firstLine);
+}
+
+void tre::BitmapTextManager::LaidOutText::layOutAppended(std::size_t firstLine)
+{
+	_layout.breakLines(_scale.x, _textbox.size.x, firstLine);
+
+	// Adding lines or widening the last one moves the earlier lines unless the text is aligned to the top-left.
+	const bool topLeft{HorizontalAlign(_textbox.textAlignment) == HorizontalAlign::LEFT &&
+					   VerticalAlign(_textbox.textAlignment) == VerticalAlign::TOP};
+	remesh(topLeft ? firstLine : 0);
+}
+
+void tre::BitmapTextManager::LaidOutText::remesh(std::size_t firstLine)
+{
+	const std::size_t firstGlyph{_layout.lines[firstLine].begin};
+	std::uint32_t     quads{_quadsBefore[firstGlyph]};
+	_quadsBefore.resize(firstGlyph);
+	_mesh.vertices.resize(quads * 4);
+	_mesh.indices.resize(quads * 6);
+
+	const std::optional<glm::mat4> transform{textboxTransform(_textbox)};
+	const auto                     addQuad{[&](const LayoutGlyph& glyph, glm::vec2 pen) {
+        _quadsBefore.resize(std::size_t(&glyph - _layout.glyphs.data()) + 1, quads);
+        _mesh.vertices.resize(_mesh.vertices.size() + 4);
+        writeGlyphMesh(std::span{_mesh.vertices}.last<4>(), *glyph.glyph, glyph.style, _scale, glyph.tint, pen,
+                       transform.has_value() ? &*transform : nullptr);
+        _mesh.indices.resize(_mesh.indices.size() + 6);
+        tr::fillPolygonIndices(_mesh.indices.end() - 6, 4, std::uint16_t(quads * 4));
+        ++quads;
+    }};
+	_layout.forEachQuad(_scale, float(_font->lineSkip), _textbox, addQuad, firstLine);
+	_quadsBefore.resize(_layout.glyphs.size() + 1, quads);
+}
+
+std::size_t tre::BitmapTextManager::LaidOutText::glyphCount() const noexcept
+{
+	return _layout.glyphs.size();
+}
+
+const tre::BitmapTextManager::Mesh& tre::BitmapTextManager::LaidOutText::mesh() const noexcept
+{
+	return _mesh;
+}
+
+std::size_t tre::BitmapTextManager::LaidOutText::revealedIndexCount(std::size_t glyphs) const noexcept
+{
+	return std::size_t{_quadsBefore[std::min(glyphs, _layout.glyphs.size())]} * 6;
+}
+
+void tre::BitmapTextManager::LaidOutText::addToLayer(int layer, std::size_t glyphs) const
+{
+	const std::size_t indices{revealedIndexCount(glyphs)};
+	if (indices == 0) {
+		return;
+	}
+
+	const Renderer2D::TextureMeshSpans mesh{renderer2D().allocateTextureMesh(layer, indices / 6 * 4, indices)};
+	std::ranges::copy(std::span{_mesh.vertices}.first(mesh.vertices.size()), mesh.vertices.begin());
+	std::ranges::copy(std::span{_mesh.indices}.first(indices), mesh.indices.begin());
 }
 
 bool tre::bitmapTextActive() noexcept
@@ -0,0 +1,158 @@
+#include "../include/tre/bitmap_text_renderer.hpp"
+#include "../include/tre/graphics_state.hpp"
+#include "../resources/bitmap_text.vert.spv.hpp"
+#include "../resources/renderer_2d.frag.spv.hpp"
+
+namespace tre {
+	constexpr std::array<glm::u8vec2, 4> GLYPH_VERTICES{{{0, 0}, {0, 1}, {1, 1}, {1, 0}}};
+} // namespace tre
+
+using VtxAttrF = tr::VertexAttributeF;
+
+tre::BitmapTextRenderer::BitmapTextRenderer()
+	: _shaderPipeline{tr::loadEmbeddedShader(BITMAP_TEXT_VERT_SPV, tr::ShaderType::VERTEX),
+					  tr::loadEmbeddedShader(RENDERER_2D_FRAG_SPV, tr::ShaderType::FRAGMENT)}
+	, _shaderGlyphBuffer{0, 1024 * sizeof(BitmapTextManager::GlyphInstance), tr::ShaderBuffer::Access::WRITE_ONLY}
+	, _glyphMetricsBuffer{0, 256 * sizeof(ShaderGlyphMetrics), tr::ShaderBuffer::Access::WRITE_ONLY}
+	, _vertexFormat{std::initializer_list<tr::VertexAttribute>{{VtxAttrF{VtxAttrF::Type::UI8, 2, false, 0}}}}
+	, _vertexBuffer{tr::asBytes(GLYPH_VERTICES)}
+	, _glyphsDirty{false}
+	, _glyphsGeneration{0}
+{
+	_shaderPipeline.fragmentShader().setUniform(1, _textureUnit);
+
+#ifndef NDEBUG
+	_shaderPipeline.setLabel("tre::BitmapTextRenderer Pipeline");
+	_shaderPipeline.vertexShader().setLabel("tre::BitmapTextRenderer Vertex Shader");
+	_shaderPipeline.fragmentShader().setLabel("tre::BitmapTextRenderer Fragment Shader");
+	_shaderGlyphBuffer.setLabel("tre::BitmapTextRenderer Shader Glyph Buffer");
+	_glyphMetricsBuffer.setLabel("tre::BitmapTextRenderer Glyph Metrics Buffer");
+	_vertexBuffer.setLabel("tre::BitmapTextRenderer Vertex Buffer");
+	_vertexFormat.setLabel("tre::BitmapTextRenderer Vertex Format");
+#endif
+}
+
+tre::BitmapTextRenderer::BitmapTextRenderer(BitmapTextRenderer&& r) noexcept = default;
+
+tre::BitmapTextRenderer::~BitmapTextRenderer() noexcept
+{
+	graphicsState().invalidate();
+}
+
+void tre::BitmapTextRenderer::addUnformattedText(std::string_view text, std::string_view font,
+												 BitmapTextManager::Style style, glm::vec2 scale, tr::RGBA8 tint,
+												 const BitmapTextManager::Textbox& textbox)
+{
+	BitmapTextManager& manager{bitmapText()};
+	assert(_glyphs.empty() || _glyphsGeneration == manager.glyphTableGeneration());
+	manager.appendUnformattedTextInstances(_glyphs, text, font, style, scale, tint, textbox);
+	_glyphsGeneration = manager.glyphTableGeneration();
+	_glyphsDirty      = true;
+}
+
+void tre::BitmapTextRenderer::addFormattedText(std::string_view text, std::string_view font, glm::vec2 scale,
+											   std::span<tr::RGBA8> colors, const BitmapTextManager::Textbox& textbox)
+{
+	BitmapTextManager& manager{bitmapText()};
+	assert(_glyphs.empty() || _glyphsGeneration == manager.glyphTableGeneration());
+	manager.appendFormattedTextInstances(_glyphs, text, font, scale, colors, textbox);
+	_glyphsGeneration = manager.glyphTableGeneration();
+	_glyphsDirty      = true;
+}
+
+void tre::BitmapTextRenderer::addFormattedText(const RichText& text, std::string_view font, glm::vec2 scale,
+											   std::span<tr::RGBA8> colors, const BitmapTextManager::Textbox& textbox)
+{
+	BitmapTextManager& manager{bitmapText()};
+	assert(_glyphs.empty() || _glyphsGeneration == manager.glyphTableGeneration());
+	manager.appendFormattedTextInstances(_glyphs, text, font, scale, colors, textbox);
+	_glyphsGeneration = manager.glyphTableGeneration();
+	_glyphsDirty      = true;
+}
+
+std::size_t tre::BitmapTextRenderer::glyphCount() const noexcept
+{
+	return _glyphs.size();
+}
+
+void tre::BitmapTextRenderer::clear() noexcept
+{
+	_glyphs.clear();
+	_glyphsDirty = true;
+}
+
+void tre::BitmapTextRenderer::uploadGlyphs()
+{
+	const std::size_t bytes{_glyphs.size() * sizeof(BitmapTextManager::GlyphInstance)};
+	if (_shaderGlyphBuffer.arrayCapacity() < bytes) {
+		_shaderGlyphBuffer = tr::ShaderBuffer(0, std::bit_ceil(bytes), tr::ShaderBuffer::Access::WRITE_ONLY);
+#ifndef NDEBUG
+		_shaderGlyphBuffer.setLabel("tre::BitmapTextRenderer Shader Glyph Buffer");
+#endif
+	}
+	_shaderGlyphBuffer.setArray(tr::rangeBytes(_glyphs));
+	_glyphsDirty = false;
+}
+
+void tre::BitmapTextRenderer::uploadGlyphMetrics()
+{
+	const BitmapTextManager&                                manager{bitmapText()};
+	const std::span<const BitmapTextManager::CompiledGlyph> table{manager.glyphTable()};
+
+	std::vector<ShaderGlyphMetrics> metrics;
+	metrics.reserve(table.size());
+	for (const BitmapTextManager::CompiledGlyph& glyph : table) {
+		metrics.push_back({glyph.offset, glyph.size, glyph.uv.tl, glyph.uv.size});
+	}
+
+	const std::size_t bytes{metrics.size() * sizeof(ShaderGlyphMetrics)};
+	if (_glyphMetricsBuffer.arrayCapacity() < bytes) {
+		_glyphMetricsBuffer = tr::ShaderBuffer(0, std::bit_ceil(bytes), tr::ShaderBuffer::Access::WRITE_ONLY);
+#ifndef NDEBUG
+		_glyphMetricsBuffer.setLabel("tre::BitmapTextRenderer Glyph Metrics Buffer");
+#endif
+	}
+	_glyphMetricsBuffer.setArray(tr::rangeBytes(metrics));
+	_metricsGeneration = manager.glyphTableGeneration();
+}
+
+void tre::BitmapTextRenderer::draw(const RenderView& view, int layer)
+{
+	if (_glyphs.empty()) {
+		return;
+	}
+
+	const BitmapTextManager& manager{bitmapText()};
+	assert(_glyphsGeneration == manager.glyphTableGeneration());
+	if (_metricsGeneration != manager.glyphTableGeneration()) {
+		uploadGlyphMetrics();
+	}
+	if (_glyphsDirty) {
+		uploadGlyphs();
+	}
+
+	const Renderer2D& renderer{renderer2D()};
+	assert(renderer.layerSampler(layer) != nullptr);
+	graphicsState().setTexture(_textureUnit, manager.texture());
+	graphicsState().setSampler(_textureUnit, *renderer.layerSampler(layer));
+	_shaderPipeline.vertexShader().setUniform(0, renderer.layerTransform(layer));
+	_shaderPipeline.vertexShader().setStorageBuffer(0, _shaderGlyphBuffer);
+	_shaderPipeline.vertexShader().setStorageBuffer(1, _glyphMetricsBuffer);
+
+	setupContext(renderer.layerBlendMode(layer));
+	view.use();
+	tr::window().graphics().drawInstances(tr::Primitive::TRI_FAN, 0, 4, _glyphs.size());
+}
+
+void tre::BitmapTextRenderer::setupContext(const tr::BlendMode& blendMode) noexcept
+{
+	GraphicsStateCache& state{graphicsState()};
+	state.useFaceCulling(false);
+	state.useDepthTest(false);
+	state.useStencilTest(false);
+	state.useBlending(true);
+	state.setBlendingMode(blendMode);
+	state.setShaderPipeline(_shaderPipeline);
+	state.setVertexFormat(_vertexFormat);
+	tr::window().graphics().setVertexBuffer(_vertexBuffer, 0, sizeof(glm::u8vec2));
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "../include/tre/debug_text_renderer.hpp"
+#include "../include/tre/graphics_state.hpp"
 #include "../include/tre/sampler.hpp"
 
 #include <GL/gl.h>
@@ -51,6 +52,7 @@ tre::DebugTextRenderer::DebugTextRenderer()
 tre::DebugTextRenderer::~DebugTextRenderer() noexcept
 {
 	_debugTextRenderer = nullptr;
+	graphicsState().invalidate();
 }
 
 void tre::DebugTextRenderer::setScale(float scale) noexcept
@@ -277,16 +279,17 @@ void tre::DebugTextRenderer::draw()
 
 void tre::DebugTextRenderer::setupContext() noexcept
 {
-	tr::window().graphics().useDepthTest(false);
-	tr::window().graphics().useScissorTest(false);
-	tr::window().graphics().useStencilTest(false);
-	tr::window().graphics().useFaceCulling(false);
-	tr::window().graphics().useBlending(true);
-	tr::window().graphics().setBlendingMode(tr::ALPHA_BLENDING);
-	tr::window().graphics().setFramebuffer(tr::window().backbuffer());
-	tr::window().graphics().setViewport({{}, tr::window().backbuffer().size()});
-	tr::window().graphics().setShaderPipeline(_shaderPipeline);
-	tr::window().graphics().setVertexFormat(_vertexFormat);
+	GraphicsStateCache& state{graphicsState()};
+	state.useDepthTest(false);
+	state.useScissorTest(false);
+	state.useStencilTest(false);
+	state.useFaceCulling(false);
+	state.useBlending(true);
+	state.setBlendingMode(tr::ALPHA_BLENDING);
+	state.setFramebuffer(tr::window().backbuffer());
+	state.setViewport({{}, tr::window().backbuffer().size()});
+	state.setShaderPipeline(_shaderPipeline);
+	state.setVertexFormat(_vertexFormat);
 	tr::window().graphics().setVertexBuffer(_vertexBuffer, 0, sizeof(glm::u8vec2));
 }
 
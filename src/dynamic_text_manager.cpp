@@ -5,8 +5,16 @@ using namespace tr::matrix_operators;
 
 namespace tre {
 	DynamicTextManager* _dynamicText{nullptr};
+	// The maximum number of glyph quads in a single mesh added to a 2D renderer layer.
+	constexpr std::size_t MAX_GLYPH_MESH_QUADS{(std::numeric_limits<std::uint16_t>::max() + 1) / 4};
 
 	glm::vec2 calculatePosAnchor(glm::vec2 textSize, const DynamicTextManager::Textbox& textbox) noexcept;
+
+	// Packs a color into an integer.
+	std::uint32_t packColor(tr::RGBA8 color) noexcept;
+
+	// Gets the font style of a rich text run.
+	tr::TTFont::Style runStyle(const RichText::Run& run) noexcept;
 } // namespace tre
 
 glm::vec2 tre::calculatePosAnchor(glm::vec2 textSize, const DynamicTextManager::Textbox& textbox) noexcept
@@ -35,14 +43,54 @@ glm::vec2 tre::calculatePosAnchor(glm::vec2 textSize, const DynamicTextManager::
 	}
 }
 
+std::uint32_t tre::packColor(tr::RGBA8 color) noexcept
+{
+	return std::uint32_t(color.r) << 24 | std::uint32_t(color.g) << 16 | std::uint32_t(color.b) << 8 | color.a;
+}
+
+tr::TTFont::Style tre::runStyle(const RichText::Run& run) noexcept
+{
+	tr::TTFont::Style style{tr::TTFont::Style::NORMAL};
+	if (run.bold) {
+		style = style ^ tr::TTFont::Style::BOLD;
+	}
+	if (run.italic) {
+		style = style ^ tr::TTFont::Style::ITALIC;
+	}
+	if (run.strikethrough) {
+		style = style ^ tr::TTFont::Style::STRIKETHROUGH;
+	}
+	if (run.underline) {
+		style = style ^ tr::TTFont::Style::UNDERLINE;
+	}
+	return style;
+}
+
+std::size_t tre::DynamicTextManager::GlyphKeyHash::operator()(const GlyphKey& key) const noexcept
+{
+	std::size_t hash{std::hash<const tr::TTFont*>{}(key.font)};
+	for (std::size_t value : {std::size_t(key.fontSize), std::size_t(key.dpi.x), std::size_t(key.dpi.y),
+							  std::size_t(key.style), std::size_t(key.codepoint), std::size_t(key.outlineThickness)}) {
+		hash ^= value + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
 tre::DynamicTextManager::DynamicTextManager() noexcept
-	: _atlas{{256, 256}}, _dpi{72, 72} // Pre-allocate atlas to make texture() always usable.
+	: _atlas{{256, 256}} // Pre-allocate atlases to make the getters usable.
+	, _dpi{72, 72}
+	, _frame{0}
+	, _nextStringName{0}
+	, _stringCacheLifetime{DEFAULT_STRING_CACHE_LIFETIME}
+	, _glyphAtlas{{256, 256}}
+	, _glyphTextAdded{false}
 {
 	assert(!dynamicTextActive());
 	_dynamicText = this;
 
 #ifndef NDEBUG
 	_atlas.setLabel("(tre) Dynamic Text Renderer Atlas");
+	_glyphAtlas.setLabel("(tre) Dynamic Text Renderer Glyph Atlas");
 #endif
 }
 
@@ -56,6 +104,18 @@ const tr::Texture2D& tre::DynamicTextManager::texture() const noexcept
 	return _atlas.texture();
 }
 
+const tr::Texture2D& tre::DynamicTextManager::glyphTexture() const noexcept
+{
+	return _glyphAtlas.texture();
+}
+
+void tre::DynamicTextManager::reserveGlyphAtlas(glm::ivec2 capacity)
+{
+	assert(!_glyphTextAdded ||
+		   (capacity.x <= _glyphAtlas.texture().size().x && capacity.y <= _glyphAtlas.texture().size().y));
+	_glyphAtlas.reserve(capacity);
+}
+
 void tre::DynamicTextManager::setDPI(unsigned int dpi) noexcept
 {
 	setDPI({dpi, dpi});
@@ -74,11 +134,18 @@ tre::Renderer2D::TextureQuad tre::DynamicTextManager::createUnformatted(const ch
 {
 	assert(!std::string_view{text}.empty());
 
+	startStringKey('U', font, fontSize, outline, textbox);
+	appendStringKey(style);
+	appendStringKey(packColor(textColor));
+	_stringKey.append(text);
+	const std::string* cached{findCachedString()};
+	if (cached != nullptr) {
+		return createMesh(*cached, textbox);
+	}
+
 	font.resize(fontSize, _dpi);
 	font.setStyle(style);
 	font.setWrapAlignment(tr::TTFont::WrapAlignment(int(textbox.textAlignment) % 3));
-
-	auto name{std::to_string(_atlas.size())};
 	if (outline.thickness != 0) {
 		font.setOutline(0);
 		const auto textBitmap{font.renderWrapped(text, textColor, textbox.size.x)};
@@ -86,12 +153,11 @@ tre::Renderer2D::TextureQuad tre::DynamicTextManager::createUnformatted(const ch
 		auto outlineBitmap{font.renderWrapped(text, outline.color, textbox.size.x)};
 		outlineBitmap.blit({outline.thickness, outline.thickness},
 						   textBitmap.sub({{}, outlineBitmap.size() - glm::ivec2{outline.thickness * 2}}));
-		_atlas.add(name, outlineBitmap);
+		return createMesh(cacheString(outlineBitmap), textbox);
 	}
 	else {
-		_atlas.add(name, font.renderWrapped(text, textColor, textbox.size.x));
+		return createMesh(cacheString(font.renderWrapped(text, textColor, textbox.size.x)), textbox);
 	}
-	return createMesh(name, textbox);
 }
 
 tre::Renderer2D::TextureQuad tre::DynamicTextManager::createUnformatted(const std::string& text, tr::TTFont& font,
@@ -115,18 +181,85 @@ tre::Renderer2D::TextureQuad tre::DynamicTextManager::createFormatted(std::strin
 {
 	assert(!text.empty());
 
-	const auto name{std::to_string(_atlas.size())};
+	startStringKey('F', font, fontSize, outline, textbox);
+	// The color count keeps the colors from being mistaken for the start of the text.
+	appendStringKey(textColors.size());
+	for (tr::RGBA8 color : textColors) {
+		appendStringKey(packColor(color));
+	}
+	_stringKey.append(text);
+	const std::string* cached{findCachedString()};
+	if (cached != nullptr) {
+		return createMesh(*cached, textbox);
+	}
+
 	const auto align{HorizontalAlign(int(textbox.textAlignment) % 3)};
 	const auto bitmap{renderMultistyleText(text, font, fontSize, _dpi, textbox.size.x, align, textColors, outline)};
-	_atlas.add(name, bitmap);
-	return createMesh(name, textbox);
+	return createMesh(cacheString(bitmap), textbox);
 }
 
-void tre::DynamicTextManager::newFrame() noexcept
+void tre::DynamicTextManager::addGlyphCachedUnformatted(int layer, std::string_view text, tr::TTFont& font,
+														int fontSize, tr::TTFont::Style style, tr::RGBA8 textColor,
+														TextOutline outline, const Textbox& textbox)
+{
+	_layoutGlyphs.clear();
+	appendLayoutGlyphs(text, font, fontSize, style, textColor, outline.thickness);
+	addLayout(layer, cachedGlyph('\n', "\n", font, fontSize, style, outline.thickness).lineSkip, outline, textbox);
+}
+
+void tre::DynamicTextManager::addGlyphCachedFormatted(int layer, std::string_view text, tr::TTFont& font,
+													  int fontSize, std::span<tr::RGBA8> textColors,
+													  TextOutline outline, const Textbox& textbox)
 {
+	assert(!textColors.empty());
+
+	const RichText richText{text};
+	tr::RGBA8      textColor{textColors.front()};
+	_layoutGlyphs.clear();
+	for (const RichText::Run& run : richText.runs()) {
+		if (run.color == RichText::DEFAULT_COLOR) {
+			textColor = textColors.front();
+		}
+		else if (run.color < textColors.size()) {
+			textColor = textColors[run.color];
+		}
+		appendLayoutGlyphs(richText.text(run), font, fontSize, runStyle(run), textColor, outline.thickness);
+	}
+	addLayout(layer, cachedGlyph('\n', "\n", font, fontSize, {}, outline.thickness).lineSkip, outline, textbox);
+}
+
+void tre::DynamicTextManager::clearGlyphCache() noexcept
+{
+	_glyphs.clear();
+	_glyphAtlas.clear();
+}
+
+void tre::DynamicTextManager::setStringCacheLifetime(unsigned int frames) noexcept
+{
+	_stringCacheLifetime = frames;
+}
+
+void tre::DynamicTextManager::clearStringCache() noexcept
+{
+	_strings.clear();
 	_atlas.clear();
 }
 
+void tre::DynamicTextManager::newFrame() noexcept
+{
+	++_frame;
+	_glyphTextAdded = false;
+	for (auto it = _strings.begin(); it != _strings.end();) {
+		if (_frame - it->second.lastUsedFrame > _stringCacheLifetime) {
+			_atlas.remove(it->second.name);
+			it = _strings.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
 tre::Renderer2D::TextureQuad tre::DynamicTextManager::createMesh(const std::string& name, const Textbox& textbox)
 {
 	const tr::RectF2 texture{_atlas[name]};
@@ -149,4 +282,213 @@ tre::DynamicTextManager& tre::dynamicText() noexcept
 {
 	assert(dynamicTextActive());
 	return *_dynamicText;
+}
+
+const tre::DynamicTextManager::CachedGlyph& tre::DynamicTextManager::cachedGlyph(std::uint32_t codepoint,
+																				 std::string_view character,
+																				 tr::TTFont& font, int fontSize,
+																				 tr::TTFont::Style style,
+																				 int               outlineThickness)
+{
+	const GlyphKey key{&font, fontSize, _dpi, std::uint32_t(style), codepoint, outlineThickness};
+	const auto     it{_glyphs.find(key)};
+	if (it != _glyphs.end()) {
+		return it->second;
+	}
+
+	font.resize(fontSize, _dpi);
+	font.setStyle(style);
+	CachedGlyph glyph{{}, {}, {}, {}, 0, float(font.lineSkip())};
+	// The character is copied to null-terminate it.
+	std::array<char, 5> cstr{};
+	std::ranges::copy(character.substr(0, cstr.size() - 1), cstr.begin());
+	if (codepoint == ' ' || codepoint == '\t') {
+		font.setOutline(outlineThickness);
+		glyph.advance = float(font.measure(cstr.data(), std::numeric_limits<int>::max()).width - 2 * outlineThickness);
+	}
+	else if (codepoint != '\n') {
+		// The fill and outline are separate entries so that all outlines of a text can be drawn before its fills.
+		font.setOutline(0);
+		const tr::Bitmap fill{font.render(cstr.data(), {255, 255, 255, 255})};
+		glyph.name    = addGlyphBitmap(fill);
+		glyph.size    = glm::vec2(fill.size());
+		glyph.advance = float(fill.size().x);
+		if (outlineThickness != 0) {
+			font.setOutline(outlineThickness);
+			const tr::Bitmap outline{font.render(cstr.data(), {255, 255, 255, 255})};
+			glyph.outlineName = addGlyphBitmap(outline);
+			glyph.outlineSize = glm::vec2(outline.size());
+		}
+	}
+	return _glyphs.emplace(key, std::move(glyph)).first->second;
+}
+
+std::string tre::DynamicTextManager::addGlyphBitmap(const tr::Bitmap& bitmap)
+{
+	std::string      name{std::to_string(_glyphAtlas.size())};
+	const glm::ivec2 oldCapacity{_glyphAtlas.texture().size()};
+	_glyphAtlas.add(name, bitmap);
+	// Growing the atlas would break the normalized texture coordinates of the glyph-cached text added this frame.
+	assert(!_glyphTextAdded || _glyphAtlas.texture().size() == oldCapacity);
+	return name;
+}
+
+void tre::DynamicTextManager::appendLayoutGlyphs(std::string_view text, tr::TTFont& font, int fontSize,
+												 tr::TTFont::Style style, tr::RGBA8 textColor, int outlineThickness)
+{
+	while (!text.empty()) {
+		std::size_t length{1};
+		while (length < text.size() && (text[length] & 0xC0) == 0x80) {
+			++length;
+		}
+		const std::string_view character{text.substr(0, length)};
+		const std::uint32_t    codepoint{*tr::utf8Begin(character)};
+		_layoutGlyphs.push_back(
+			{&cachedGlyph(codepoint, character, font, fontSize, style, outlineThickness), codepoint, textColor});
+		text.remove_prefix(length);
+	}
+}
+
+void tre::DynamicTextManager::addLayout(int layer, float lineSkip, TextOutline outline, const Textbox& textbox)
+{
+	const float maxWidth{textbox.size.x * _dpi.x / 72.0f};
+	std::size_t lineBegin{0};
+	float       width{0};
+	// The last breakable glyph of the current line and the width of the line before it.
+	std::optional<std::size_t> lastBreakable;
+	float                      widthBeforeBreakable{0};
+	_layoutLines.clear();
+	for (std::size_t i = 0; i < _layoutGlyphs.size();) {
+		const LayoutGlyph& glyph{_layoutGlyphs[i]};
+		const bool         breakable{glyph.codepoint == ' ' || glyph.codepoint == '\t'};
+		if (glyph.codepoint == '\n') {
+			_layoutLines.push_back({lineBegin, i, width});
+			lineBegin = ++i;
+			width     = 0;
+			lastBreakable.reset();
+			continue;
+		}
+
+		if (i != lineBegin && width + glyph.glyph->advance > maxWidth) {
+			if (breakable) {
+				// The overflowing whitespace is swallowed by the line break.
+				_layoutLines.push_back({lineBegin, i, width});
+				lineBegin = ++i;
+			}
+			else if (lastBreakable.has_value()) {
+				_layoutLines.push_back({lineBegin, *lastBreakable, widthBeforeBreakable});
+				lineBegin = i = *lastBreakable + 1;
+			}
+			else {
+				_layoutLines.push_back({lineBegin, i, width});
+				lineBegin = i;
+			}
+			width = 0;
+			lastBreakable.reset();
+			continue;
+		}
+
+		if (breakable) {
+			lastBreakable        = i;
+			widthBeforeBreakable = width;
+		}
+		width += glyph.glyph->advance;
+		++i;
+	}
+	_layoutLines.push_back({lineBegin, _layoutGlyphs.size(), width});
+
+	// The text is laid out in pixels, but positioned in points like the rest of the manager's text.
+	const glm::vec2 pointScale{72.0f / glm::vec2(_dpi)};
+	const float     blockWidth{std::ranges::max(_layoutLines, {}, &LayoutLine::width).width};
+	const glm::vec2 posAnchor{calculatePosAnchor(glm::vec2{blockWidth, _layoutLines.size() * lineSkip} * pointScale,
+												 textbox)};
+	// Adds the quads of either the outlines or the fills of the glyphs, all outlines being drawn first.
+	const auto addQuads{[&](bool outlines) {
+		// The fill of an outlined glyph is inset by the thickness of the outline.
+		const glm::vec2 inset{outlines ? 0.0f : float(outline.thickness)};
+		for (std::size_t line = 0; line < _layoutLines.size(); ++line) {
+			const LayoutLine& lineInfo{_layoutLines[line]};
+			float             x{0};
+			switch (HorizontalAlign(int(textbox.textAlignment) % 3)) {
+			case HorizontalAlign::LEFT:
+				break;
+			case HorizontalAlign::CENTER:
+				x = (blockWidth - lineInfo.width) / 2;
+				break;
+			case HorizontalAlign::RIGHT:
+				x = blockWidth - lineInfo.width;
+				break;
+			}
+
+			for (std::size_t i = lineInfo.begin; i < lineInfo.end; ++i) {
+				const LayoutGlyph& glyph{_layoutGlyphs[i]};
+				const std::string& name{outlines ? glyph.glyph->outlineName : glyph.glyph->name};
+				if (!name.empty()) {
+					const glm::vec2  offset{(glm::vec2{x, line * lineSkip} + inset) * pointScale};
+					const glm::vec2  size{outlines ? glyph.glyph->outlineSize : glyph.glyph->size};
+					const tr::RectF2 uv{_glyphAtlas[name]};
+					Renderer2D::TextureQuad& quad{_layoutQuads.emplace_back()};
+					tr::fillRotatedRectangleVertices((quad | tr::positions).begin(), textbox.pos, posAnchor - offset,
+													 size * pointScale, textbox.rotation);
+					tr::fillRectVertices((quad | tr::uvs).begin(), uv.tl, uv.size);
+					std::ranges::fill(quad | tr::colors, outlines ? outline.color : glyph.tint);
+				}
+				x += glyph.glyph->advance;
+			}
+		}
+	}};
+	_layoutQuads.clear();
+	if (outline.thickness != 0) {
+		addQuads(true);
+	}
+	addQuads(false);
+	_glyphTextAdded = true;
+
+	// Text that doesn't fit in one mesh is split into several.
+	Renderer2D& renderer{renderer2D()};
+	for (std::size_t first = 0; first < _layoutQuads.size(); first += MAX_GLYPH_MESH_QUADS) {
+		const std::size_t                  count{std::min(_layoutQuads.size() - first, MAX_GLYPH_MESH_QUADS)};
+		const Renderer2D::TextureMeshSpans mesh{renderer.allocateTextureMesh(layer, count * 4, count * 6)};
+		for (std::size_t quad = 0; quad < count; ++quad) {
+			std::ranges::copy(_layoutQuads[first + quad], mesh.vertices.begin() + quad * 4);
+			tr::fillPolygonIndices(mesh.indices.begin() + quad * 6, 4, std::uint16_t(quad * 4));
+		}
+	}
+}
+
+void tre::DynamicTextManager::startStringKey(char kind, const tr::TTFont& font, int fontSize, TextOutline outline,
+											 const Textbox& textbox)
+{
+	_stringKey.clear();
+	_stringKey.push_back(kind);
+	appendStringKey(&font);
+	appendStringKey(fontSize);
+	appendStringKey(_dpi);
+	appendStringKey(outline.thickness);
+	appendStringKey(packColor(outline.color));
+	// Only the width and horizontal alignment of the textbox affect the rendered bitmap.
+	appendStringKey(textbox.size.x);
+	appendStringKey(int(textbox.textAlignment) % 3);
+}
+
+template <class T> void tre::DynamicTextManager::appendStringKey(const T& value)
+{
+	_stringKey.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+const std::string* tre::DynamicTextManager::findCachedString() noexcept
+{
+	const auto it{_strings.find(_stringKey)};
+	if (it == _strings.end()) {
+		return nullptr;
+	}
+	it->second.lastUsedFrame = _frame;
+	return &it->second.name;
+}
+
+const std::string& tre::DynamicTextManager::cacheString(const tr::SubBitmap& bitmap)
+{
+	std::string name{std::to_string(_nextStringName++)};
+	_atlas.add(name, bitmap);
+	return _strings.emplace(_stringKey, CachedString{std::move(name), _frame}).first->second.name;
 }
\ No newline at end of file
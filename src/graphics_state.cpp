@@ -0,0 +1,136 @@
+#include "../include/tre/graphics_state.hpp"
+
+namespace tre {
+	GraphicsStateCache _graphicsState;
+} // namespace tre
+
+template <class T, class Fn>
+void tre::GraphicsStateCache::set(std::optional<T>& current, const T& value, Fn issue) noexcept
+{
+	if (current != value) {
+		current = value;
+		issue();
+		++_counters.issued;
+	}
+	else {
+		++_counters.skipped;
+	}
+}
+
+void tre::GraphicsStateCache::setFramebuffer(tr::BasicFramebuffer& framebuffer) noexcept
+{
+	set(_framebuffer, &framebuffer, [&] { tr::window().graphics().setFramebuffer(framebuffer); });
+}
+
+void tre::GraphicsStateCache::setViewport(const tr::RectI2& viewport) noexcept
+{
+	set(_viewport, viewport, [&] { tr::window().graphics().setViewport(viewport); });
+}
+
+void tre::GraphicsStateCache::setDepthRange(double min, double max) noexcept
+{
+	set(_depthRange, {min, max}, [&] { tr::window().graphics().setDepthRange(min, max); });
+}
+
+void tre::GraphicsStateCache::useScissorTest(bool use) noexcept
+{
+	set(_scissorTest, use, [&] { tr::window().graphics().useScissorTest(use); });
+}
+
+void tre::GraphicsStateCache::setScissorBox(const tr::RectI2& box) noexcept
+{
+	set(_scissorBox, box, [&] { tr::window().graphics().setScissorBox(box); });
+}
+
+void tre::GraphicsStateCache::useFaceCulling(bool use) noexcept
+{
+	set(_faceCulling, use, [&] { tr::window().graphics().useFaceCulling(use); });
+}
+
+void tre::GraphicsStateCache::useDepthTest(bool use) noexcept
+{
+	set(_depthTest, use, [&] { tr::window().graphics().useDepthTest(use); });
+}
+
+void tre::GraphicsStateCache::useStencilTest(bool use) noexcept
+{
+	set(_stencilTest, use, [&] { tr::window().graphics().useStencilTest(use); });
+}
+
+void tre::GraphicsStateCache::useBlending(bool use) noexcept
+{
+	set(_blending, use, [&] { tr::window().graphics().useBlending(use); });
+}
+
+void tre::GraphicsStateCache::setBlendingMode(const tr::BlendMode& blendMode) noexcept
+{
+	set(_blendMode, blendMode, [&] { tr::window().graphics().setBlendingMode(blendMode); });
+}
+
+void tre::GraphicsStateCache::setShaderPipeline(const tr::OwningShaderPipeline& pipeline) noexcept
+{
+	set(_pipeline, &pipeline, [&] { tr::window().graphics().setShaderPipeline(pipeline); });
+}
+
+void tre::GraphicsStateCache::setVertexFormat(const tr::VertexFormat& format) noexcept
+{
+	set(_vertexFormat, &format, [&] { tr::window().graphics().setVertexFormat(format); });
+}
+
+void tre::GraphicsStateCache::setTexture(tr::TextureUnit& unit, const tr::Texture2D& texture)
+{
+	auto& state{_textureUnits[&unit]};
+	if (state.texture != &texture) {
+		state.texture = &texture;
+		unit.setTexture(texture);
+		++_counters.issued;
+	}
+	else {
+		++_counters.skipped;
+	}
+}
+
+void tre::GraphicsStateCache::setSampler(tr::TextureUnit& unit, const tr::Sampler& sampler)
+{
+	auto& state{_textureUnits[&unit]};
+	if (state.sampler != &sampler) {
+		state.sampler = &sampler;
+		unit.setSampler(sampler);
+		++_counters.issued;
+	}
+	else {
+		++_counters.skipped;
+	}
+}
+
+void tre::GraphicsStateCache::invalidate() noexcept
+{
+	_framebuffer.reset();
+	_viewport.reset();
+	_depthRange.reset();
+	_scissorTest.reset();
+	_scissorBox.reset();
+	_faceCulling.reset();
+	_depthTest.reset();
+	_stencilTest.reset();
+	_blending.reset();
+	_blendMode.reset();
+	_pipeline.reset();
+	_vertexFormat.reset();
+	_textureUnits.clear();
+}
+
+const tre::GraphicsStateCache::Counters& tre::GraphicsStateCache::counters() const noexcept
+{
+	return _counters;
+}
+
+void tre::GraphicsStateCache::resetCounters() noexcept
+{
+	_counters = {};
+}
+
+tre::GraphicsStateCache& tre::graphicsState() noexcept
+{
+	return _graphicsState;
+}
\ No newline at end of file
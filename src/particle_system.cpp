@@ -0,0 +1,331 @@
+#include "../include/tre/particle_system.hpp"
+#include "../include/tre/graphics_state.hpp"
+#include "../resources/particle_system.vert.spv.hpp"
+#include "../resources/renderer_2d.frag.spv.hpp"
+#include <latch>
+
+namespace tre {
+	constexpr std::array<glm::u8vec2, 4> PARTICLE_VERTICES{{{0, 0}, {0, 1}, {1, 1}, {1, 0}}};
+	// The minimum number of particles worth handing to a separate thread.
+	constexpr std::size_t MIN_PARTICLES_PER_THREAD{4096};
+
+	// Mutates every array of a particle structure in the same way.
+	template <class Fn> void forEachArray(auto& particles, Fn fn);
+	// Converts a color to a vector of its channels.
+	glm::vec4 toVec4(tr::RGBA8 color) noexcept;
+	// Checks that the ranges of an emitter can be sampled from.
+	bool validRanges(const ParticleSystem::Emitter& emitter) noexcept;
+} // namespace tre
+
+using VtxAttrF = tr::VertexAttributeF;
+
+template <class Fn> void tre::forEachArray(auto& particles, Fn fn)
+{
+	fn(particles.posX);
+	fn(particles.posY);
+	fn(particles.velX);
+	fn(particles.velY);
+	fn(particles.life);
+	fn(particles.lifeRate);
+}
+
+glm::vec4 tre::toVec4(tr::RGBA8 color) noexcept
+{
+	return {color.r, color.g, color.b, color.a};
+}
+
+bool tre::validRanges(const ParticleSystem::Emitter& emitter) noexcept
+{
+	return emitter.minLifetime.count() > 0 && emitter.minLifetime <= emitter.maxLifetime &&
+		   emitter.minSpeed <= emitter.maxSpeed;
+}
+
+tre::ParticleSystem::ParticleSystem()
+	: _shaderPipeline{tr::loadEmbeddedShader(PARTICLE_SYSTEM_VERT_SPV, tr::ShaderType::VERTEX),
+					  tr::loadEmbeddedShader(RENDERER_2D_FRAG_SPV, tr::ShaderType::FRAGMENT)}
+	, _shaderParticleBuffer{0, 1024 * sizeof(ShaderParticle), tr::ShaderBuffer::Access::WRITE_ONLY}
+	, _vertexFormat{std::initializer_list<tr::VertexAttribute>{{VtxAttrF{VtxAttrF::Type::UI8, 2, false, 0}}}}
+	, _vertexBuffer{tr::asBytes(PARTICLE_VERTICES)}
+	, _workerPool{std::make_unique<WorkerPool>()}
+{
+	_shaderPipeline.fragmentShader().setUniform(1, _textureUnit);
+
+#ifndef NDEBUG
+	_shaderPipeline.setLabel("tre::ParticleSystem Pipeline");
+	_shaderPipeline.vertexShader().setLabel("tre::ParticleSystem Vertex Shader");
+	_shaderPipeline.fragmentShader().setLabel("tre::ParticleSystem Fragment Shader");
+	_shaderParticleBuffer.setLabel("tre::ParticleSystem Shader Particle Buffer");
+	_vertexBuffer.setLabel("tre::ParticleSystem Vertex Buffer");
+	_vertexFormat.setLabel("tre::ParticleSystem Vertex Format");
+#endif
+}
+
+tre::ParticleSystem::ParticleSystem(ParticleSystem&& r) noexcept = default;
+
+tre::ParticleSystem::~ParticleSystem() noexcept
+{
+	graphicsState().invalidate();
+}
+
+void tre::ParticleSystem::addEmitter(int id, const Emitter& emitter)
+{
+	assert(!_emitters.contains(id));
+	assert(validRanges(emitter));
+	_emitters.emplace(id, EmitterState{emitter, {}, 0});
+}
+
+tre::ParticleSystem::Emitter& tre::ParticleSystem::emitter(int id) noexcept
+{
+	assert(_emitters.contains(id));
+	return _emitters.find(id)->second.emitter;
+}
+
+const tre::ParticleSystem::Emitter& tre::ParticleSystem::emitter(int id) const noexcept
+{
+	assert(_emitters.contains(id));
+	return _emitters.find(id)->second.emitter;
+}
+
+void tre::ParticleSystem::removeEmitter(int id) noexcept
+{
+	_emitters.erase(id);
+}
+
+void tre::ParticleSystem::burst(int id, std::size_t count)
+{
+	assert(_emitters.contains(id));
+	spawn(_emitters.find(id)->second, count);
+}
+
+void tre::ParticleSystem::clear() noexcept
+{
+	for (auto& [id, state] : _emitters) {
+		forEachArray(state.particles, [](std::vector<float>& array) { array.clear(); });
+	}
+	_shaderParticles.clear();
+}
+
+std::size_t tre::ParticleSystem::particleCount() const noexcept
+{
+	std::size_t count{0};
+	for (const auto& [id, state] : _emitters) {
+		count += state.particles.life.size();
+	}
+	return count;
+}
+
+void tre::ParticleSystem::spawn(EmitterState& state, std::size_t count)
+{
+	const auto& emitter{state.emitter};
+	auto&       particles{state.particles};
+	const auto  oldSize{particles.life.size()};
+	// The ranges are checked here too, as they may have been changed through emitter().
+	assert(validRanges(emitter));
+	try {
+		forEachArray(particles, [&](std::vector<float>& array) { array.resize(oldSize + count); });
+	}
+	catch (...) {
+		forEachArray(particles, [&](std::vector<float>& array) { array.resize(oldSize); });
+		throw;
+	}
+
+	std::uniform_real_distribution<float> unit{-0.5f, 0.5f};
+	std::uniform_real_distribution<float> speed{emitter.minSpeed, emitter.maxSpeed};
+	std::uniform_real_distribution<float> lifetime{emitter.minLifetime.count(), emitter.maxLifetime.count()};
+	for (std::size_t i = oldSize; i < oldSize + count; ++i) {
+		const float angle{emitter.direction.rads() + emitter.spread.rads() * unit(_rng)};
+		const float particleSpeed{speed(_rng)};
+		particles.posX[i]     = emitter.pos.x + emitter.size.x * unit(_rng);
+		particles.posY[i]     = emitter.pos.y + emitter.size.y * unit(_rng);
+		particles.velX[i]     = std::cos(angle) * particleSpeed;
+		particles.velY[i]     = std::sin(angle) * particleSpeed;
+		particles.life[i]     = 0;
+		particles.lifeRate[i] = 1 / lifetime(_rng);
+	}
+}
+
+template <class Fn> void tre::ParticleSystem::forEachRange(unsigned int threads, Fn fn)
+{
+	const std::size_t total{particleCount()};
+	const std::size_t perThread{std::max((total + threads - 1) / threads, MIN_PARTICLES_PER_THREAD)};
+
+	// Hands the particles in [begin, end) to the function, split along emitter boundaries.
+	const auto processRange{[&](std::size_t begin, std::size_t end) {
+		std::size_t offset{0};
+		for (auto& [id, state] : _emitters) {
+			const std::size_t size{state.particles.life.size()};
+			if (offset + size > begin && offset < end) {
+				const std::size_t first{std::max(begin, offset) - offset};
+				const std::size_t last{std::min(end, offset + size) - offset};
+				fn(state, first, last, offset);
+			}
+			offset += size;
+		}
+	}};
+
+	const std::size_t ranges{(total + perThread - 1) / perThread};
+	if (ranges > 1) {
+		std::latch                         done{std::ptrdiff_t(ranges - 1)};
+		std::vector<std::function<void()>> jobs;
+		jobs.reserve(ranges - 1);
+		for (std::size_t begin = perThread; begin < total; begin += perThread) {
+			jobs.emplace_back([&, begin] {
+				processRange(begin, std::min(begin + perThread, total));
+				done.count_down();
+			});
+		}
+		_workerPool->reserve(ranges - 1);
+		_workerPool->run(jobs);
+		processRange(0, perThread);
+		done.wait();
+	}
+	else {
+		processRange(0, total);
+	}
+}
+
+void tre::ParticleSystem::WorkerPool::reserve(std::size_t workers)
+{
+	std::lock_guard lock{_mutex};
+	while (_workers.size() < workers) {
+		_workers.emplace_back([this](std::stop_token stop) { work(stop); });
+	}
+}
+
+void tre::ParticleSystem::WorkerPool::run(std::span<std::function<void()>> jobs)
+{
+	{
+		std::lock_guard lock{_mutex};
+		const std::size_t queued{_jobs.size()};
+		try {
+			std::ranges::move(jobs, std::back_inserter(_jobs));
+		}
+		catch (...) {
+			_jobs.resize(queued);
+			throw;
+		}
+	}
+	_jobQueued.notify_all();
+}
+
+void tre::ParticleSystem::WorkerPool::work(std::stop_token stop)
+{
+	std::unique_lock lock{_mutex};
+	while (_jobQueued.wait(lock, stop, [&] { return !_jobs.empty(); })) {
+		const std::function<void()> job{std::move(_jobs.front())};
+		_jobs.pop_front();
+		lock.unlock();
+		job();
+		lock.lock();
+	}
+}
+
+void tre::ParticleSystem::update(tr::SecondsF delta, unsigned int threads)
+{
+	assert(threads > 0);
+	const float dt{delta.count()};
+
+	for (auto& [id, state] : _emitters) {
+		state.spawnAccumulator += state.emitter.rate * dt;
+		const auto count{std::size_t(state.spawnAccumulator)};
+		spawn(state, count);
+		state.spawnAccumulator -= count;
+	}
+
+	forEachRange(threads, [=](EmitterState& state, std::size_t begin, std::size_t end, std::size_t) {
+		auto&       particles{state.particles};
+		const float accelerationX{state.emitter.acceleration.x * dt};
+		const float accelerationY{state.emitter.acceleration.y * dt};
+		float*      posX{particles.posX.data()};
+		float*      posY{particles.posY.data()};
+		float*      velX{particles.velX.data()};
+		float*      velY{particles.velY.data()};
+		float*      life{particles.life.data()};
+		const auto* lifeRate{particles.lifeRate.data()};
+		for (std::size_t i = begin; i < end; ++i) {
+			velX[i] += accelerationX;
+			velY[i] += accelerationY;
+			posX[i] += velX[i] * dt;
+			posY[i] += velY[i] * dt;
+			life[i] += lifeRate[i] * dt;
+		}
+	});
+
+	// Expired particles are swapped with the last one, so the order of the particles isn't preserved.
+	for (auto& [id, state] : _emitters) {
+		auto& particles{state.particles};
+		for (std::size_t i = 0; i < particles.life.size();) {
+			if (particles.life[i] >= 1) {
+				forEachArray(particles, [=](std::vector<float>& array) {
+					array[i] = array.back();
+					array.pop_back();
+				});
+			}
+			else {
+				++i;
+			}
+		}
+	}
+
+	_shaderParticles.resize(particleCount());
+	forEachRange(threads, [this](EmitterState& state, std::size_t begin, std::size_t end, std::size_t offset) {
+		const auto&     emitter{state.emitter};
+		const auto&     particles{state.particles};
+		const glm::vec4 startColor{toVec4(emitter.startColor)};
+		const glm::vec4 colorDelta{toVec4(emitter.endColor) - startColor};
+		const float     sizeDelta{emitter.endSize - emitter.startSize};
+		for (std::size_t i = begin; i < end; ++i) {
+			const float     life{particles.life[i]};
+			const glm::vec4 color{startColor + colorDelta * life};
+			_shaderParticles[offset + i] = {{particles.posX[i], particles.posY[i]},
+											emitter.startSize + sizeDelta * life,
+											{std::uint8_t(color.x), std::uint8_t(color.y), std::uint8_t(color.z),
+											 std::uint8_t(color.w)},
+											emitter.uv.tl,
+											emitter.uv.size};
+		}
+	});
+}
+
+void tre::ParticleSystem::draw(const RenderView& view, int layer)
+{
+	if (_shaderParticles.empty()) {
+		return;
+	}
+
+	if (_shaderParticleBuffer.arrayCapacity() < _shaderParticles.size() * sizeof(ShaderParticle)) {
+		const auto newCapacity{std::bit_ceil(_shaderParticles.size() * sizeof(ShaderParticle))};
+		_shaderParticleBuffer = tr::ShaderBuffer(0, newCapacity, tr::ShaderBuffer::Access::WRITE_ONLY);
+#ifndef NDEBUG
+		_shaderParticleBuffer.setLabel("tre::ParticleSystem Shader Particle Buffer");
+#endif
+	}
+	_shaderParticleBuffer.setArray(tr::rangeBytes(_shaderParticles));
+
+	const Renderer2D&    renderer{renderer2D()};
+	const tr::Texture2D* texture{renderer.layerTexture(layer)};
+	if (texture != nullptr) {
+		graphicsState().setTexture(_textureUnit, *texture);
+		graphicsState().setSampler(_textureUnit, *renderer.layerSampler(layer));
+	}
+	_shaderPipeline.vertexShader().setUniform(0, renderer.layerTransform(layer));
+	_shaderPipeline.vertexShader().setUniform(1, int(texture != nullptr));
+	_shaderPipeline.vertexShader().setStorageBuffer(0, _shaderParticleBuffer);
+
+	setupContext(renderer.layerBlendMode(layer));
+	view.use();
+	tr::window().graphics().drawInstances(tr::Primitive::TRI_FAN, 0, 4, _shaderParticles.size());
+}
+
+void tre::ParticleSystem::setupContext(const tr::BlendMode& blendMode) noexcept
+{
+	GraphicsStateCache& state{graphicsState()};
+	state.useFaceCulling(false);
+	state.useDepthTest(false);
+	state.useStencilTest(false);
+	state.useBlending(true);
+	state.setBlendingMode(blendMode);
+	state.setShaderPipeline(_shaderPipeline);
+	state.setVertexFormat(_vertexFormat);
+	tr::window().graphics().setVertexBuffer(_vertexBuffer, 0, sizeof(glm::u8vec2));
+}
\ No newline at end of file
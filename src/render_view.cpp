@@ -1,9 +1,5 @@
 #include "../include/tre/render_view.hpp"
-
-namespace tre {
-	// The last set render view is kept track of to prevent unnecessary state changes.
-	std::optional<tre::RenderView> _lastView;
-} // namespace tre
+#include "../include/tre/graphics_state.hpp"
 
 tre::RenderView::RenderView(tr::BasicFramebuffer& framebuffer) noexcept
 	: RenderView{framebuffer, {{}, framebuffer.size()}, 0, 1}
@@ -27,14 +23,27 @@ bool tre::operator==(const RenderView& l, const RenderView& r) noexcept
 		   l._depthMax == r._depthMax;
 }
 
+const tr::RectI2& tre::RenderView::viewport() const noexcept
+{
+	return _viewport;
+}
+
+tr::BasicFramebuffer& tre::RenderView::framebuffer() const noexcept
+{
+	return _framebuffer;
+}
+
 void tre::RenderView::use() const noexcept
 {
-	if (_lastView != *this) {
-		tr::window().graphics().setFramebuffer(_framebuffer.get());
-		tr::window().graphics().setViewport(_viewport);
-		tr::window().graphics().setDepthRange(_depthMin, _depthMax);
-		tr::window().graphics().useScissorTest(true);
-		tr::window().graphics().setScissorBox(_viewport);
-		_lastView = *this;
-	}
+	use({{}, _viewport.size});
+}
+
+void tre::RenderView::use(const tr::RectI2& scissorBox) const noexcept
+{
+	GraphicsStateCache& state{graphicsState()};
+	state.setFramebuffer(_framebuffer.get());
+	state.setViewport(_viewport);
+	state.setDepthRange(_depthMin, _depthMax);
+	state.useScissorTest(true);
+	state.setScissorBox({_viewport.tl + scissorBox.tl, scissorBox.size});
 }
\ No newline at end of file
@@ -1,36 +1,203 @@
 #include "../include/tre/renderer_2d.hpp"
+#include "../include/tre/graphics_state.hpp"
+#include "../include/tre/sampler.hpp"
 #include "../resources/renderer_2d.frag.spv.hpp"
 #include "../resources/renderer_2d.vert.spv.hpp"
+#include "../resources/renderer_2d_mdi.vert.spv.hpp"
+#include <GL/glew.h>
 
 namespace tre {
 	inline constexpr glm::vec2 UNTEXTURED_UV{-100, -100};
-	tre::Renderer2D*           _renderer2D{nullptr};
+	// The maximum number of vertices addressable by a single draw.
+	inline constexpr std::size_t MAX_DRAW_VERTICES{std::numeric_limits<std::uint16_t>::max() + 1};
+	// The maximum number of quads drawable with the shared index buffer at once.
+	inline constexpr std::size_t MAX_SHARED_QUADS{MAX_DRAW_VERTICES / 4};
+	// Shape segment counts are multiples of this, so that circles can be split into quarters.
+	inline constexpr int SHAPE_SEGMENT_STEP{4};
+	inline constexpr int MIN_SHAPE_SEGMENTS{8};
+	inline constexpr int MAX_SHAPE_SEGMENTS{256};
+	// The maximum distance between a curved shape and its approximation, in pixels.
+	inline constexpr float SHAPE_TOLERANCE{0.25f};
+	// The maximum length of a polyline miter join relative to the polyline's thickness.
+	inline constexpr float MITER_LIMIT{2};
+	// The number of draws timestamp queries are kept around for before being reused.
+	inline constexpr std::size_t GPU_TIMER_FRAMES{4};
+	tre::Renderer2D*             _renderer2D{nullptr};
+
+	// Creates the contents of the shared index buffer: indices for the maximum number of quads.
+	std::vector<std::uint16_t> createSharedIndices();
+	// Hashes the bytes of an object or range of objects.
+	template <class T> std::size_t hashBytes(std::span<T> span) noexcept;
+	// Combines two hashes into one.
+	std::size_t combineHashes(std::size_t seed, std::size_t hash) noexcept;
+
+	// Identifies frame capture streams.
+	inline constexpr std::array<char, 8> FRAME_CAPTURE_MAGIC{'T', 'R', 'E', '2', 'D', 'C', 'A', 'P'};
+	inline constexpr std::uint32_t       FRAME_CAPTURE_VERSION{1};
+	// Primitive types as stored in frame captures.
+	enum class CapturedPrimitive : std::uint8_t {
+		QUAD,
+		// Fans are stored as meshes, but older captures may still contain them.
+		FAN,
+		MESH
+	};
+
+	// Writes the bytes of a trivially copyable value or a range of them to a binary stream.
+	template <class T> void writeBinary(std::ostream& os, const T& value);
+	template <class T> void writeBinary(std::ostream& os, std::span<const T> span);
+	// Reads the bytes of a trivially copyable value or a range of them from a binary stream.
+	template <class T> T    readBinary(std::istream& is);
+	template <class T> void readBinary(std::istream& is, std::span<T> span);
+	// Reads a number of trivially copyable values from a binary stream into a vector, growing it in bounded steps so
+	// that a corrupt count runs into the end of the stream instead of causing a huge allocation.
+	template <class T> void readBinary(std::istream& is, std::vector<T>& vector, std::size_t count);
+	// Checks that a blending mode read from a frame capture only contains valid multipliers and functions.
+	bool validBlendMode(const tr::BlendMode& blendMode) noexcept;
+	// Writes the vertices and indices of a primitive to a binary stream.
+	void writePrimitive(std::ostream& os, std::span<const tr::TintVtx2> vertices,
+						std::span<const std::uint16_t> indices);
 } // namespace tre
 
+std::vector<std::uint16_t> tre::createSharedIndices()
+{
+	std::vector<std::uint16_t> indices;
+	indices.reserve(MAX_SHARED_QUADS * 6);
+	for (std::size_t i = 0; i < MAX_SHARED_QUADS; ++i) {
+		tr::fillPolygonIndices(std::back_inserter(indices), 4, i * 4);
+	}
+	return indices;
+}
+
+template <class T> std::size_t tre::hashBytes(std::span<T> span) noexcept
+{
+	return std::hash<std::string_view>{}({reinterpret_cast<const char*>(span.data()), span.size_bytes()});
+}
+
+std::size_t tre::combineHashes(std::size_t seed, std::size_t hash) noexcept
+{
+	return seed ^ (hash + 0x9E3779B97F4A7C15 + (seed << 6) + (seed >> 2));
+}
+
+template <class T> void tre::writeBinary(std::ostream& os, const T& value)
+{
+	os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T> void tre::writeBinary(std::ostream& os, std::span<const T> span)
+{
+	os.write(reinterpret_cast<const char*>(span.data()), span.size_bytes());
+}
+
+template <class T> T tre::readBinary(std::istream& is)
+{
+	T value;
+	readBinary(is, std::span{&value, 1});
+	return value;
+}
+
+template <class T> void tre::readBinary(std::istream& is, std::span<T> span)
+{
+	if (!is.read(reinterpret_cast<char*>(span.data()), span.size_bytes())) {
+		throw FrameCaptureDecodingError{"Unexpected end of frame capture stream."};
+	}
+}
+
+template <class T> void tre::readBinary(std::istream& is, std::vector<T>& vector, std::size_t count)
+{
+	constexpr std::size_t STEP{65536 / sizeof(T)};
+	vector.clear();
+	while (vector.size() < count) {
+		const auto oldSize{vector.size()};
+		vector.resize(std::min(count, oldSize + STEP));
+		readBinary(is, std::span{vector}.subspan(oldSize));
+	}
+}
+
+bool tre::validBlendMode(const tr::BlendMode& blendMode) noexcept
+{
+	// The blending enumerators of tr have the values of their OpenGL counterparts.
+	constexpr std::array<GLenum, 15> MULTIPLIERS{GL_ZERO, GL_ONE, GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR, GL_DST_COLOR,
+												 GL_ONE_MINUS_DST_COLOR, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+												 GL_DST_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_CONSTANT_COLOR,
+												 GL_ONE_MINUS_CONSTANT_COLOR, GL_CONSTANT_ALPHA,
+												 GL_ONE_MINUS_CONSTANT_ALPHA, GL_SRC_ALPHA_SATURATE};
+	constexpr std::array<GLenum, 5>  FUNCTIONS{GL_FUNC_ADD, GL_FUNC_SUBTRACT, GL_FUNC_REVERSE_SUBTRACT, GL_MIN, GL_MAX};
+
+	const auto valid{[](std::span<const GLenum> values, auto value) {
+		return std::ranges::find(values, GLenum(value)) != values.end();
+	}};
+	const auto multiplier{[&](auto value) { return valid(MULTIPLIERS, value); }};
+	const auto function{[&](auto value) { return valid(FUNCTIONS, value); }};
+
+	const auto& [rgbSrc, rgbFn, rgbDst, alphaSrc, alphaFn, alphaDst]{blendMode};
+	return multiplier(rgbSrc) && function(rgbFn) && multiplier(rgbDst) && multiplier(alphaSrc) && function(alphaFn) &&
+		   multiplier(alphaDst);
+}
+
+void tre::writePrimitive(std::ostream& os, std::span<const tr::TintVtx2> vertices,
+						 std::span<const std::uint16_t> indices)
+{
+	writeBinary(os, std::uint32_t(vertices.size()));
+	writeBinary(os, vertices);
+	writeBinary(os, std::uint32_t(indices.size()));
+	writeBinary(os, indices);
+}
+
 tre::Renderer2D::Renderer2D()
-	: _shaderPipeline{tr::loadEmbeddedShader(RENDERER_2D_VERT_SPV, tr::ShaderType::VERTEX),
+	: _shaderPipeline{std::in_place, tr::loadEmbeddedShader(RENDERER_2D_VERT_SPV, tr::ShaderType::VERTEX),
 					  tr::loadEmbeddedShader(RENDERER_2D_FRAG_SPV, tr::ShaderType::FRAGMENT)}
+	, _textureUnit{std::in_place}
+	, _sharedIndexBuffer{std::in_place}
+	, _cacheQuadBuffer{std::in_place}
+	, _vertexBuffer{std::in_place}
+	, _indexBuffer{std::in_place}
 {
 	assert(!renderer2DActive());
 	_renderer2D = this;
 
+	uploadStaticBuffers();
+
 #ifndef NDEBUG
-	_shaderPipeline.setLabel("tre::Renderer2D Pipeline");
-	_shaderPipeline.vertexShader().setLabel("tre::Renderer2D Vertex Shader");
-	_shaderPipeline.fragmentShader().setLabel("tre::Renderer2D Fragment Shader");
-	_vertexBuffer.setLabel("tre::Renderer2D Vertex Buffer");
-	_indexBuffer.setLabel("tre::Renderer2D Index Buffer");
+	_shaderPipeline->setLabel("tre::Renderer2D Pipeline");
+	_shaderPipeline->vertexShader().setLabel("tre::Renderer2D Vertex Shader");
+	_shaderPipeline->fragmentShader().setLabel("tre::Renderer2D Fragment Shader");
+	_sharedIndexBuffer->setLabel("tre::Renderer2D Shared Index Buffer");
+	_cacheQuadBuffer->setLabel("tre::Renderer2D Cache Quad Vertex Buffer");
+	_vertexBuffer->setLabel("tre::Renderer2D Vertex Buffer");
+	_indexBuffer->setLabel("tre::Renderer2D Index Buffer");
 #endif
 }
 
+tre::Renderer2D::Renderer2D(NullGraphics)
+	: _recordedCalls{std::in_place}
+{
+	assert(!renderer2DActive());
+	_renderer2D = this;
+
+	uploadStaticBuffers();
+}
+
 tre::Renderer2D::Renderer2D(Renderer2D&& r) noexcept
 	: _shaderPipeline{std::move(r._shaderPipeline)}
 	, _textureUnit{std::move(r._textureUnit)}
+	, _sharedIndexBuffer{std::move(r._sharedIndexBuffer)}
+	, _cacheQuadBuffer{std::move(r._cacheQuadBuffer)}
 	, _vertexBuffer{std::move(r._vertexBuffer)}
 	, _indexBuffer{std::move(r._indexBuffer)}
 	, _vertices{std::move(r._vertices)}
 	, _indices{std::move(r._indices)}
+	, _draws{std::move(r._draws)}
 	, _layers{std::move(r._layers)}
+	, _preparedLayers{std::move(r._preparedLayers)}
+	, _signatures{std::move(r._signatures)}
+	, _dirtyRects{std::move(r._dirtyRects)}
+	, _stats{std::move(r._stats)}
+	, _targetViewSize{r._targetViewSize}
+	, _unitCircles{std::move(r._unitCircles)}
+	, _gpuTimerFrames{std::move(r._gpuTimerFrames)}
+	, _gpuTimerFrame{r._gpuTimerFrame}
+	, _recordedCalls{std::move(r._recordedCalls)}
+	, _multiDraw{std::move(r._multiDraw)}
 {
 	if (_renderer2D == &r) {
 		_renderer2D = this;
@@ -42,6 +209,7 @@ tre::Renderer2D::~Renderer2D() noexcept
 	if (_renderer2D == this) {
 		_renderer2D = nullptr;
 	}
+	graphicsState().invalidate();
 }
 
 void tre::Renderer2D::addColorOnlyLayer(int priority, const glm::mat4& transform, const tr::BlendMode& blendMode)
@@ -80,12 +248,213 @@ void tre::Renderer2D::setLayerTransform(int layer, const glm::mat4& transform) n
 void tre::Renderer2D::setLayerBlendMode(int layer, const tr::BlendMode& blendMode) noexcept
 {
 	assert(_layers.contains(layer));
-	_layers.at(layer).blendMode = blendMode;
+	auto& data{_layers.at(layer)};
+	assert(!data.retained.has_value() || !data.retained->cache.has_value() || cacheBlendMode(blendMode).has_value());
+	data.blendMode = blendMode;
+}
+
+const tr::Texture2D* tre::Renderer2D::layerTexture(int layer) const noexcept
+{
+	assert(_layers.contains(layer));
+	return _layers.at(layer).texture;
+}
+
+const tr::Sampler* tre::Renderer2D::layerSampler(int layer) const noexcept
+{
+	assert(_layers.contains(layer));
+	return _layers.at(layer).sampler;
+}
+
+const glm::mat4& tre::Renderer2D::layerTransform(int layer) const noexcept
+{
+	assert(_layers.contains(layer));
+	return _layers.at(layer).transform;
+}
+
+const tr::BlendMode& tre::Renderer2D::layerBlendMode(int layer) const noexcept
+{
+	assert(_layers.contains(layer));
+	return _layers.at(layer).blendMode;
+}
+
+void tre::Renderer2D::setLayerRetained(int layer, bool retained)
+{
+	assert(_layers.contains(layer));
+	auto& data{_layers.at(layer)};
+	if (!retained) {
+		if (data.retained.has_value() && data.retained->cache.has_value()) {
+			graphicsState().invalidate();
+		}
+		data.retained.reset();
+	}
+	else if (!data.retained.has_value()) {
+		data.retained.emplace();
+		if (!nullGraphics()) {
+			data.retained->vertexBuffer.emplace();
+			data.retained->indexBuffer.emplace();
+#ifndef NDEBUG
+			data.retained->vertexBuffer->setLabel(std::format("tre::Renderer2D Layer {} Vertex Buffer", layer));
+			data.retained->indexBuffer->setLabel(std::format("tre::Renderer2D Layer {} Index Buffer", layer));
+#endif
+		}
+	}
+}
+
+void tre::Renderer2D::invalidateLayer(int layer) noexcept
+{
+	assert(_layers.contains(layer));
+	auto& data{_layers.at(layer)};
+	assert(data.retained.has_value());
+	data.primitives.clear();
+	data.retained->draws.clear();
+	data.retained->primitives = 0;
+	if (data.retained->cache.has_value()) {
+		data.retained->cache->dirty = true;
+	}
+}
+
+void tre::Renderer2D::setLayerCached(int layer, bool cached)
+{
+	assert(_layers.contains(layer));
+	auto& data{_layers.at(layer)};
+	if (!cached) {
+		if (data.retained.has_value() && data.retained->cache.has_value()) {
+			graphicsState().invalidate();
+			data.retained->cache.reset();
+		}
+	}
+	else {
+		assert(cacheBlendMode(data.blendMode).has_value());
+		setLayerRetained(layer, true);
+		if (!nullGraphics() && !data.retained->cache.has_value()) {
+			data.retained->cache.emplace();
+#ifndef NDEBUG
+			data.retained->cache->framebuffer.setLabel(
+				std::format("tre::Renderer2D Layer {} Cache Framebuffer", layer));
+#endif
+		}
+	}
+}
+
+std::optional<tr::BlendMode> tre::Renderer2D::cacheBlendMode(const tr::BlendMode& blendMode) noexcept
+{
+	if (blendMode.rgbFn != tr::BlendFunction::ADD || blendMode.rgbDst != tr::BlendMultiplier::ONE_MINUS_SRC_ALPHA) {
+		return std::nullopt;
+	}
+	switch (blendMode.rgbSrc) {
+	case tr::BlendMultiplier::SRC_ALPHA:
+		// The color is premultiplied as it is blended into the cache, and the alpha is accumulated like a
+		// premultiplied color, so that compositing the cache is equivalent to blending each primitive in turn.
+		return tr::BlendMode{tr::BlendMultiplier::SRC_ALPHA, tr::BlendFunction::ADD,
+							 tr::BlendMultiplier::ONE_MINUS_SRC_ALPHA, tr::BlendMultiplier::ONE, tr::BlendFunction::ADD,
+							 tr::BlendMultiplier::ONE_MINUS_SRC_ALPHA};
+	case tr::BlendMultiplier::ONE:
+		return CACHE_COMPOSITE_BLENDING;
+	default:
+		return std::nullopt;
+	}
+}
+
+void tre::Renderer2D::markLayerDirty(int layer) noexcept
+{
+	assert(_layers.contains(layer));
+	auto& data{_layers.at(layer)};
+	assert(data.retained.has_value() && data.retained->cache.has_value());
+	data.retained->cache->dirty = true;
+}
+
+void tre::Renderer2D::enableDirtyRectTracking(const glm::vec4& clearColor, std::size_t bufferCount)
+{
+	assert(bufferCount >= 1);
+	_dirtyRects.emplace(clearColor, bufferCount);
+}
+
+void tre::Renderer2D::disableDirtyRectTracking() noexcept
+{
+	_dirtyRects.reset();
+}
+
+void tre::Renderer2D::invalidateDirtyRects() noexcept
+{
+	if (_dirtyRects.has_value()) {
+		_dirtyRects->views.clear();
+	}
 }
 
 void tre::Renderer2D::removeLayer(int layer) noexcept
 {
-	_layers.erase(layer);
+	const auto it{_layers.find(layer)};
+	if (it != _layers.end()) {
+		if (it->second.retained.has_value() && it->second.retained->cache.has_value()) {
+			graphicsState().invalidate();
+		}
+		_layers.erase(it);
+	}
+}
+
+std::size_t tre::Renderer2D::PrimitiveList::size() const noexcept
+{
+	return primitives.size();
+}
+
+bool tre::Renderer2D::PrimitiveList::empty() const noexcept
+{
+	return primitives.empty();
+}
+
+void tre::Renderer2D::PrimitiveList::clear() noexcept
+{
+	primitives.clear();
+	vertexPool.clear();
+	indexPool.clear();
+}
+
+void tre::Renderer2D::PrimitiveList::append(const PrimitiveList& list)
+{
+	const auto firstVertex{vertexPool.size()};
+	const auto firstIndex{indexPool.size()};
+	for (Primitive primitive : list.primitives) {
+		if (TextureMesh* mesh{std::get_if<TextureMesh>(&primitive)}) {
+			mesh->firstVertex += firstVertex;
+			mesh->firstIndex += firstIndex;
+		}
+		primitives.push_back(primitive);
+	}
+	vertexPool.insert(vertexPool.end(), list.vertexPool.begin(), list.vertexPool.end());
+	indexPool.insert(indexPool.end(), list.indexPool.begin(), list.indexPool.end());
+}
+
+tre::Renderer2D::TextureMeshSpans tre::Renderer2D::PrimitiveList::addMesh(std::size_t vertices, std::size_t indices)
+{
+	const TextureMesh mesh{vertexPool.size(), vertices, indexPool.size(), indices};
+	primitives.emplace_back(mesh);
+	try {
+		vertexPool.resize(mesh.firstVertex + vertices);
+		indexPool.resize(mesh.firstIndex + indices);
+	}
+	catch (...) {
+		primitives.pop_back();
+		vertexPool.resize(mesh.firstVertex);
+		throw;
+	}
+	return {std::span{vertexPool}.subspan(mesh.firstVertex), std::span{indexPool}.subspan(mesh.firstIndex)};
+}
+
+std::span<tr::TintVtx2> tre::Renderer2D::PrimitiveList::addFan(std::size_t vertices)
+{
+	const TextureMeshSpans mesh{addMesh(vertices, (vertices - 2) * 3)};
+	tr::fillPolygonIndices(mesh.indices.begin(), vertices, 0);
+	return mesh.vertices;
+}
+
+std::span<const tr::TintVtx2> tre::Renderer2D::PrimitiveList::meshVertices(const TextureMesh& mesh) const noexcept
+{
+	return std::span{vertexPool}.subspan(mesh.firstVertex, mesh.vertices);
+}
+
+std::span<const std::uint16_t> tre::Renderer2D::PrimitiveList::meshIndices(const TextureMesh& mesh) const noexcept
+{
+	return std::span{indexPool}.subspan(mesh.firstIndex, mesh.indices);
 }
 
 void tre::Renderer2D::addColorQuad(int layer, const ColorQuad& quad)
@@ -97,183 +466,1136 @@ void tre::Renderer2D::addColorQuad(int layer, const ColorQuad& quad)
 		textureQuad[i].uv    = UNTEXTURED_UV;
 		textureQuad[i].color = quad[i].color;
 	}
-	_layers[layer].primitives.emplace_back(std::in_place_type<TextureQuad>, textureQuad);
+	_layers[layer].primitives.primitives.emplace_back(std::in_place_type<TextureQuad>, textureQuad);
 }
 
 void tre::Renderer2D::addTextureQuad(int layer, const TextureQuad& quad)
 {
 	assert(_layers.contains(layer));
 	assert(_layers.at(layer).texture != nullptr && _layers.at(layer).sampler != nullptr);
-	_layers[layer].primitives.emplace_back(std::in_place_type<TextureQuad>, quad);
+	_layers[layer].primitives.primitives.emplace_back(std::in_place_type<TextureQuad>, quad);
 }
 
 void tre::Renderer2D::addColorFan(int layer, const ColorFan& fan)
 {
 	assert(_layers.contains(layer));
-	assert(fan.size() >= 3);
-	TextureFan textureFan(fan.size());
+	assert(fan.size() >= 3 && fan.size() <= MAX_DRAW_VERTICES);
+	const std::span<tr::TintVtx2> textureFan{_layers[layer].primitives.addFan(fan.size())};
 	for (std::size_t i = 0; i < fan.size(); ++i) {
 		textureFan[i].pos   = fan[i].pos;
 		textureFan[i].uv    = UNTEXTURED_UV;
 		textureFan[i].color = fan[i].color;
 	}
-	_layers[layer].primitives.emplace_back(std::in_place_type<TextureFan>, std::move(textureFan));
 }
 
 void tre::Renderer2D::addTextureFan(int layer, const TextureFan& fan)
 {
-	addTextureFan(layer, TextureFan{fan});
+	assert(_layers.contains(layer));
+	assert(_layers.at(layer).texture != nullptr && _layers.at(layer).sampler != nullptr);
+	assert(fan.size() >= 3 && fan.size() <= MAX_DRAW_VERTICES);
+	std::ranges::copy(fan, _layers[layer].primitives.addFan(fan.size()).begin());
 }
 
 void tre::Renderer2D::addTextureFan(int layer, TextureFan&& fan)
 {
-	assert(_layers.contains(layer));
-	assert(_layers.at(layer).texture != nullptr && _layers.at(layer).sampler != nullptr);
-	assert(fan.size() >= 3);
-	_layers[layer].primitives.emplace_back(std::in_place_type<TextureFan>, std::move(fan));
+	addTextureFan(layer, std::as_const(fan));
 }
 
 void tre::Renderer2D::addColorMesh(int layer, const std::vector<tr::ClrVtx2>& vertices,
-								   const std::vector<std::uint16_t>& indices)
+								   std::vector<std::uint16_t>&& indices)
 {
-	addColorMesh(layer, vertices, std::vector<std::uint16_t>{indices});
+	addColorMesh(layer, vertices, std::as_const(indices));
 }
 
 void tre::Renderer2D::addColorMesh(int layer, const std::vector<tr::ClrVtx2>& vertices,
-								   std::vector<std::uint16_t>&& indices)
+								   const std::vector<std::uint16_t>& indices)
 {
 	assert(_layers.contains(layer));
 	assert(std::ranges::max(indices) == vertices.size() - 1);
-	std::vector<tr::TintVtx2> textureVertices(vertices.size());
+	const TextureMeshSpans mesh{_layers[layer].primitives.addMesh(vertices.size(), indices.size())};
 	for (std::size_t i = 0; i < vertices.size(); ++i) {
-		textureVertices[i].pos   = vertices[i].pos;
-		textureVertices[i].uv    = UNTEXTURED_UV;
-		textureVertices[i].color = vertices[i].color;
+		mesh.vertices[i].pos   = vertices[i].pos;
+		mesh.vertices[i].uv    = UNTEXTURED_UV;
+		mesh.vertices[i].color = vertices[i].color;
 	}
-	_layers[layer].primitives.emplace_back(std::in_place_type<TextureMesh>, std::move(textureVertices),
-										   std::move(indices));
+	std::ranges::copy(indices, mesh.indices.begin());
 }
 
 void tre::Renderer2D::addTextureMesh(int layer, const std::vector<tr::TintVtx2>& vertices,
 									 const std::vector<std::uint16_t>& indices)
 {
-	addTextureMesh(layer, std::vector<tr::TintVtx2>{vertices}, std::vector<std::uint16_t>{indices});
+	assert(_layers.contains(layer));
+	assert(_layers.at(layer).texture != nullptr && _layers.at(layer).sampler != nullptr);
+	assert(std::ranges::max(indices) == vertices.size() - 1);
+	const TextureMeshSpans mesh{_layers[layer].primitives.addMesh(vertices.size(), indices.size())};
+	std::ranges::copy(vertices, mesh.vertices.begin());
+	std::ranges::copy(indices, mesh.indices.begin());
 }
 
 void tre::Renderer2D::addTextureMesh(int layer, std::vector<tr::TintVtx2>&& vertices,
 									 std::vector<std::uint16_t>&& indices)
+{
+	addTextureMesh(layer, std::as_const(vertices), std::as_const(indices));
+}
+
+tre::Renderer2D::TextureMeshSpans tre::Renderer2D::allocateTextureMesh(int layer, std::size_t vertices,
+																		std::size_t indices)
 {
 	assert(_layers.contains(layer));
 	assert(_layers.at(layer).texture != nullptr && _layers.at(layer).sampler != nullptr);
-	assert(std::ranges::max(indices) == vertices.size() - 1);
-	_layers[layer].primitives.emplace_back(std::in_place_type<TextureMesh>, std::move(vertices), std::move(indices));
+	assert(vertices >= 3 && vertices <= MAX_DRAW_VERTICES);
+	return _layers[layer].primitives.addMesh(vertices, indices);
+}
+
+bool tre::Renderer2D::nullGraphics() const noexcept
+{
+	return _recordedCalls.has_value();
+}
+
+void tre::Renderer2D::record(GraphicsCall::Type type, std::size_t offset, std::size_t size)
+{
+	if (nullGraphics()) {
+		_recordedCalls->push_back({type, offset, size});
+	}
+}
+
+void tre::Renderer2D::uploadStaticBuffers()
+{
+	upload(_sharedIndexBuffer, createSharedIndices());
+	std::array<tr::TintVtx2, 4> cacheQuad;
+	tr::fillRectVertices((cacheQuad | tr::positions).begin(), {-1, -1}, {2, 2});
+	tr::fillRectVertices((cacheQuad | tr::uvs).begin(), {0, 0}, {1, 1});
+	std::ranges::fill(cacheQuad | tr::colors, tr::RGBA8{255, 255, 255, 255});
+	upload(_cacheQuadBuffer, cacheQuad);
+}
+
+template <class Buffer, class Range> void tre::Renderer2D::upload(std::optional<Buffer>& buffer, const Range& data)
+{
+	if (buffer.has_value()) {
+		buffer->set(data);
+	}
+	else {
+		record(std::same_as<Buffer, tr::VertexBuffer> ? GraphicsCall::Type::UPLOAD_VERTICES
+													  : GraphicsCall::Type::UPLOAD_INDICES,
+			   0, std::span{data}.size_bytes());
+	}
+}
+
+void tre::Renderer2D::setTargetViewSize(glm::ivec2 size) noexcept
+{
+	_targetViewSize = size;
+}
+
+void tre::Renderer2D::addColorCircle(int layer, glm::vec2 center, float radius, tr::RGBA8 color)
+{
+	assert(_layers.contains(layer));
+	const auto circle{unitCircle(layer, radius)};
+	const auto fan{_layers[layer].primitives.addFan(circle.size() - 1)};
+	for (std::size_t i = 0; i < fan.size(); ++i) {
+		fan[i] = {center + circle[i] * radius, UNTEXTURED_UV, color};
+	}
+}
+
+void tre::Renderer2D::addColorArc(int layer, glm::vec2 center, float radius, tr::AngleF start, tr::AngleF size,
+								  float thickness, tr::RGBA8 color)
+{
+	assert(_layers.contains(layer));
+	const auto        circle{unitCircle(layer, radius + thickness / 2)};
+	const float       step{2 * std::numbers::pi_v<float> / (circle.size() - 1)};
+	const float       sizeRads{std::clamp(size.rads(), -2 * std::numbers::pi_v<float>, 2 * std::numbers::pi_v<float>)};
+	const std::size_t segments{std::max(std::size_t(std::ceil(std::abs(sizeRads) / step)), std::size_t{1})};
+	const float       direction{sizeRads < 0 ? -1.0f : 1.0f};
+	const float       innerRadius{radius - thickness / 2};
+	const float       outerRadius{radius + thickness / 2};
+
+	const auto [vertices, indices]{_layers[layer].primitives.addMesh((segments + 1) * 2, segments * 6)};
+	for (std::size_t i = 0; i <= segments; ++i) {
+		// Points of the table are rotated to the start of the arc, except for the last one which is exact.
+		glm::vec2 unit;
+		if (i == segments) {
+			unit = {std::cos(start.rads() + sizeRads), std::sin(start.rads() + sizeRads)};
+		}
+		else {
+			const glm::vec2 point{circle[i].x, circle[i].y * direction};
+			unit = {point.x * start.cos() - point.y * start.sin(), point.x * start.sin() + point.y * start.cos()};
+		}
+		vertices[i * 2]     = {center + unit * innerRadius, UNTEXTURED_UV, color};
+		vertices[i * 2 + 1] = {center + unit * outerRadius, UNTEXTURED_UV, color};
+	}
+	for (std::size_t i = 0; i < segments; ++i) {
+		const auto base{std::uint16_t(i * 2)};
+		std::ranges::copy(std::initializer_list<std::uint16_t>{base, std::uint16_t(base + 1), std::uint16_t(base + 3),
+															   base, std::uint16_t(base + 3), std::uint16_t(base + 2)},
+						  indices.begin() + i * 6);
+	}
+}
+
+void tre::Renderer2D::addColorRoundedRect(int layer, const tr::RectF2& rect, float radius, tr::RGBA8 color)
+{
+	assert(_layers.contains(layer));
+	assert(radius <= std::min(rect.size.x, rect.size.y) / 2);
+	const auto        circle{unitCircle(layer, radius)};
+	const std::size_t quarter{(circle.size() - 1) / 4};
+	const glm::vec2   min{rect.tl + radius};
+	const glm::vec2   max{rect.tl + rect.size - radius};
+	const std::array  corners{max, glm::vec2{min.x, max.y}, min, glm::vec2{max.x, min.y}};
+
+	const auto fan{_layers[layer].primitives.addFan((quarter + 1) * 4)};
+	for (std::size_t corner = 0; corner < 4; ++corner) {
+		for (std::size_t i = 0; i <= quarter; ++i) {
+			fan[corner * (quarter + 1) + i] = {corners[corner] + circle[corner * quarter + i] * radius, UNTEXTURED_UV,
+											   color};
+		}
+	}
+}
+
+void tre::Renderer2D::addColorPolyline(int layer, std::span<const glm::vec2> points, float thickness, tr::RGBA8 color)
+{
+	assert(_layers.contains(layer));
+	assert(points.size() >= 2 && points.size() <= MAX_DRAW_VERTICES / 2);
+	const auto normal{[&](std::size_t i) {
+		const glm::vec2 direction{glm::normalize(points[i + 1] - points[i])};
+		return glm::vec2{-direction.y, direction.x};
+	}};
+
+	const auto [vertices, indices]{_layers[layer].primitives.addMesh(points.size() * 2, (points.size() - 1) * 6)};
+	for (std::size_t i = 0; i < points.size(); ++i) {
+		glm::vec2 offset;
+		if (i == 0 || i == points.size() - 1) {
+			offset = normal(i == 0 ? 0 : i - 1) * (thickness / 2);
+		}
+		else {
+			const glm::vec2 prevNormal{normal(i - 1)};
+			const glm::vec2 sum{prevNormal + normal(i)};
+			// The miter is undefined if the polyline turns back on itself.
+			const glm::vec2 miter{glm::length(sum) < 0.0001f ? prevNormal : glm::normalize(sum)};
+			offset = miter * (thickness / 2 / std::max(glm::dot(miter, prevNormal), 1 / MITER_LIMIT));
+		}
+		vertices[i * 2]     = {points[i] - offset, UNTEXTURED_UV, color};
+		vertices[i * 2 + 1] = {points[i] + offset, UNTEXTURED_UV, color};
+	}
+	for (std::size_t i = 0; i < points.size() - 1; ++i) {
+		const auto base{std::uint16_t(i * 2)};
+		std::ranges::copy(std::initializer_list<std::uint16_t>{base, std::uint16_t(base + 1), std::uint16_t(base + 3),
+															   base, std::uint16_t(base + 3), std::uint16_t(base + 2)},
+						  indices.begin() + i * 6);
+	}
+}
+
+std::span<const glm::vec2> tre::Renderer2D::unitCircle(int layer, float radius)
+{
+	// Clip space is two units across, so one clip space unit spans half of the view.
+	const auto& transform{_layers.at(layer).transform};
+	const float pixelRadius{radius * std::max(glm::length(glm::vec2{transform[0]}) * _targetViewSize.x,
+											  glm::length(glm::vec2{transform[1]}) * _targetViewSize.y) / 2};
+
+	// Segment count at which the distance between the circle and its approximation is within the tolerance.
+	int segments{MAX_SHAPE_SEGMENTS};
+	if (pixelRadius <= SHAPE_TOLERANCE) {
+		segments = MIN_SHAPE_SEGMENTS;
+	}
+	else if (const float angle{std::acos(1 - SHAPE_TOLERANCE / pixelRadius)}; angle > 0) {
+		const int exact{int(std::ceil(std::numbers::pi_v<float> / angle))};
+		segments = std::clamp((exact + SHAPE_SEGMENT_STEP - 1) / SHAPE_SEGMENT_STEP * SHAPE_SEGMENT_STEP,
+							  MIN_SHAPE_SEGMENTS, MAX_SHAPE_SEGMENTS);
+	}
+
+	if (_unitCircles.size() <= std::size_t(segments / SHAPE_SEGMENT_STEP)) {
+		_unitCircles.resize(segments / SHAPE_SEGMENT_STEP + 1);
+	}
+	auto& circle{_unitCircles[segments / SHAPE_SEGMENT_STEP]};
+	if (circle.empty()) {
+		// The first point is repeated at the end so that arcs and corners never have to wrap around.
+		circle.resize(segments + 1);
+		for (int i = 0; i <= segments; ++i) {
+			const float angle{2 * std::numbers::pi_v<float> * i / segments};
+			circle[i] = {std::cos(angle), std::sin(angle)};
+		}
+	}
+	return circle;
 }
 
 void tre::Renderer2D::setupContext() noexcept
 {
-	tr::window().graphics().useFaceCulling(false);
-	tr::window().graphics().useDepthTest(false);
-	tr::window().graphics().useStencilTest(false);
-	tr::window().graphics().useBlending(true);
-	tr::window().graphics().setShaderPipeline(_shaderPipeline);
-	tr::window().graphics().setVertexFormat(tr::TintVtx2::vertexFormat());
+	if (nullGraphics()) {
+		return;
+	}
+
+	GraphicsStateCache& state{graphicsState()};
+	state.useFaceCulling(false);
+	state.useDepthTest(false);
+	state.useStencilTest(false);
+	state.useBlending(true);
+	state.setShaderPipeline(*_shaderPipeline);
+	state.setVertexFormat(tr::TintVtx2::vertexFormat());
 }
 
-std::uint16_t tre::Renderer2D::writeToBuffers(const Primitive& primitive, std::uint16_t index)
+void tre::Renderer2D::writeToBuffers(const PrimitiveList& primitives, std::vector<Draw>& draws)
 {
-	const auto textureQuad{[&](const TextureQuad& rect) -> std::uint16_t {
-		_vertices.insert(_vertices.end(), rect.begin(), rect.end());
-		tr::fillPolygonIndices(back_inserter(_indices), 4, index);
-		return index + 4;
+	// Draws from before the current primitives belong to another layer and can't be merged into.
+	const auto firstDraw{draws.size()};
+	const auto canMerge{[&](Draw::Type type) { return draws.size() > firstDraw && draws.back().type == type; }};
+
+	const auto textureQuad{[&](const TextureQuad& quad) {
+		if (!canMerge(Draw::Type::QUADS) || draws.back().indices == MAX_SHARED_QUADS * 6) {
+			draws.push_back({Draw::Type::QUADS, _vertices.size(), 0, 0, 0});
+		}
+		draws.back().indices += 6;
+		draws.back().vertices += 4;
+		_vertices.insert(_vertices.end(), quad.begin(), quad.end());
 	}};
-	const auto textureFan{[&](const TextureFan& fan) -> std::uint16_t {
-		_vertices.insert(_vertices.end(), fan.begin(), fan.end());
-		tr::fillPolygonIndices(back_inserter(_indices), fan.size(), index);
-		return index + fan.size();
+	// Meshes, which fans are stored as, are merged into the same draws with their indices rebased onto the draw's
+	// base vertex.
+	const auto meshDraw{[&](std::size_t vertices) {
+		if (!canMerge(Draw::Type::MESHES) ||
+			_vertices.size() - draws.back().baseVertex + vertices > MAX_DRAW_VERTICES) {
+			draws.push_back({Draw::Type::MESHES, _vertices.size(), _indices.size(), 0, 0});
+		}
+		return _vertices.size() - draws.back().baseVertex;
 	}};
-	const auto textureMesh{[&](const TextureMesh& mesh) -> std::uint16_t {
-		auto indices{mesh.second | std::views::transform([base = _vertices.size()](auto idx) { return idx + base; })};
-		_vertices.insert(_vertices.end(), mesh.first.begin(), mesh.first.end());
+	const auto textureMesh{[&](const TextureMesh& mesh) {
+		const auto base{meshDraw(mesh.vertices)};
+		const auto vertices{primitives.meshVertices(mesh)};
+		const auto indices{primitives.meshIndices(mesh) |
+						   std::views::transform([=](auto idx) { return std::uint16_t(idx + base); })};
+		_vertices.insert(_vertices.end(), vertices.begin(), vertices.end());
 		_indices.insert(_indices.end(), indices.begin(), indices.end());
-		return index + mesh.first.size();
+		draws.back().indices += mesh.indices;
+		draws.back().vertices += mesh.vertices;
 	}};
 
-	return std::visit(tr::Overloaded{textureQuad, textureFan, textureMesh}, primitive);
+	for (auto& primitive : primitives.primitives) {
+		std::visit(tr::Overloaded{textureQuad, textureMesh}, primitive);
+	}
+}
+
+void tre::Renderer2D::signPrimitives(const PrimitiveList& primitives, std::vector<PrimitiveSignature>& signatures)
+{
+	const auto sign{[&](std::span<const tr::TintVtx2> vertices, std::span<const std::uint16_t> indices) {
+		glm::vec2 min{vertices.front().pos};
+		glm::vec2 max{min};
+		for (auto& vertex : vertices) {
+			min = glm::min(min, vertex.pos);
+			max = glm::max(max, vertex.pos);
+		}
+		signatures.push_back({combineHashes(hashBytes(vertices), hashBytes(indices)), {min, max - min}});
+	}};
+
+	for (auto& primitive : primitives.primitives) {
+		std::visit(tr::Overloaded{[&](const TextureQuad& quad) { sign(quad, {}); },
+								  [&](const TextureMesh& mesh) {
+									  sign(primitives.meshVertices(mesh), primitives.meshIndices(mesh));
+								  }},
+				   primitive);
+	}
+}
+
+void tre::Renderer2D::uploadRetainedLayer(Layer& layer)
+{
+	auto& retained{*layer.retained};
+	if (retained.primitives == layer.primitives.size()) {
+		return;
+	}
+
+	_vertices.clear();
+	_indices.clear();
+	retained.draws.clear();
+	writeToBuffers(layer.primitives, retained.draws);
+	upload(retained.vertexBuffer, _vertices);
+	if (!_indices.empty()) {
+		upload(retained.indexBuffer, _indices);
+	}
+	_stats.uploadedBytes += _vertices.size() * sizeof(tr::TintVtx2) + _indices.size() * sizeof(std::uint16_t);
+	retained.primitives = layer.primitives.size();
+	retained.signatures.clear();
+	signPrimitives(layer.primitives, retained.signatures);
+	if (retained.cache.has_value()) {
+		retained.cache->dirty = true;
+	}
 }
 
-std::vector<std::size_t> tre::Renderer2D::uploadToGraphicsBuffers(decltype(_layers)::iterator end)
+void tre::Renderer2D::prepareUpToLayer(int maxPriority)
 {
+	_preparedLayers.clear();
+	_stats = {.layerGpuTimes = std::move(_stats.layerGpuTimes)};
+	collectGpuTimers();
+
+	const std::ranges::subrange range{_layers.begin(), _layers.lower_bound(maxPriority)};
+	const auto                  empty{[](const Layer& layer) {
+        return layer.primitives.empty() && (!layer.retained.has_value() || layer.retained->draws.empty());
+    }};
+	if (std::ranges::all_of(range | std::views::values, empty)) {
+		return;
+	}
+
+	for (auto& layer : range | std::views::values) {
+		if (layer.retained.has_value()) {
+			uploadRetainedLayer(layer);
+		}
+	}
+
 	_vertices.clear();
 	_indices.clear();
-	std::uint16_t            index{0};
-	std::vector<std::size_t> offsets;
+	_draws.clear();
+	_signatures.clear();
+	for (auto& [priority, layer] : range) {
+		if (layer.retained.has_value()) {
+			if (!layer.retained->draws.empty()) {
+				_stats.layerPrimitives.emplace(priority, layer.primitives.size());
+				_preparedLayers.push_back({priority, layer.texture, layer.sampler, layer.transform, layer.blendMode,
+										   &*layer.retained, 0, layer.retained->draws.size(), 0,
+										   layer.retained->signatures.size()});
+			}
+		}
+		else {
+			const auto firstDraw{_draws.size()};
+			const auto firstSignature{_signatures.size()};
+			writeToBuffers(layer.primitives, _draws);
+			if (_dirtyRects.has_value()) {
+				signPrimitives(layer.primitives, _signatures);
+			}
+			if (_draws.size() != firstDraw) {
+				_stats.layerPrimitives.emplace(priority, layer.primitives.size());
+				_preparedLayers.push_back({priority, layer.texture, layer.sampler, layer.transform, layer.blendMode,
+										   nullptr, firstDraw, _draws.size() - firstDraw, firstSignature,
+										   _signatures.size() - firstSignature});
+			}
+			layer.primitives.clear();
+		}
+	}
+	if (!_vertices.empty()) {
+		upload(_vertexBuffer, _vertices);
+	}
+	if (!_indices.empty()) {
+		upload(_indexBuffer, _indices);
+	}
+	_stats.uploadedBytes += _vertices.size() * sizeof(tr::TintVtx2) + _indices.size() * sizeof(std::uint16_t);
+}
+
+void tre::Renderer2D::prepare()
+{
+	prepareUpToLayer(std::numeric_limits<int>::max());
+}
+
+void tre::Renderer2D::drawPrepared(const RenderView& view)
+{
+	drawPrepared(view, glm::mat4{1});
+}
+
+void tre::Renderer2D::setDrawState(BoundState& bound, const tr::Texture2D* texture, const tr::Sampler* sampler,
+								   const tr::BlendMode& blendMode)
+{
+	if (bound.texture != texture && texture != nullptr) {
+		bound.texture = texture;
+		if (_textureUnit.has_value()) {
+			graphicsState().setTexture(*_textureUnit, *texture);
+		}
+		record(GraphicsCall::Type::SET_TEXTURE);
+		++_stats.textureChanges;
+	}
+	if (bound.sampler != sampler && sampler != nullptr) {
+		bound.sampler = sampler;
+		if (_textureUnit.has_value()) {
+			graphicsState().setSampler(*_textureUnit, *sampler);
+		}
+		record(GraphicsCall::Type::SET_SAMPLER);
+		++_stats.samplerChanges;
+	}
+	if (bound.blendMode != blendMode) {
+		bound.blendMode = blendMode;
+		if (!nullGraphics()) {
+			graphicsState().setBlendingMode(blendMode);
+		}
+		record(GraphicsCall::Type::SET_BLEND_MODE);
+		++_stats.blendModeChanges;
+	}
+}
 
-	for (auto& layer : std::ranges::subrange{_layers.begin(), end} | std::views::values) {
-		offsets.emplace_back(_indices.size());
-		for (auto& primitive : layer.primitives) {
-			index = writeToBuffers(primitive, index);
+void tre::Renderer2D::setTransform(BoundState& bound, const glm::mat4& transform)
+{
+	if (bound.transform != transform) {
+		bound.transform = transform;
+		if (_shaderPipeline.has_value()) {
+			_shaderPipeline->vertexShader().setUniform(0, transform);
 		}
-		layer.primitives.clear();
+		record(GraphicsCall::Type::SET_TRANSFORM);
 	}
-	offsets.emplace_back(_indices.size()); // Offset to end, simplifies a loop in the main function.
+}
 
-	_vertexBuffer.set(_vertices);
-	_indexBuffer.set(_indices);
-	tr::window().graphics().setVertexBuffer(_vertexBuffer, 0, sizeof(tr::TintVtx2));
-	tr::window().graphics().setIndexBuffer(_indexBuffer);
-	return offsets;
+void tre::Renderer2D::usePipeline(bool multiDraw)
+{
+	if (!nullGraphics()) {
+		graphicsState().setShaderPipeline(multiDraw ? _multiDraw->pipeline : *_shaderPipeline);
+	}
 }
 
-void tre::Renderer2D::drawUpToLayer(int maxPriority, const RenderView& target)
+void tre::Renderer2D::bindBuffers(BoundState& bound, const std::optional<tr::VertexBuffer>& vertexBuffer,
+								  std::size_t baseVertex, const std::optional<tr::IndexBuffer>& indexBuffer)
+{
+	// Binding the vertex buffer at an offset takes the place of a base vertex.
+	if (bound.vertexBuffer != &vertexBuffer || bound.baseVertex != baseVertex) {
+		bound.vertexBuffer = &vertexBuffer;
+		bound.baseVertex   = baseVertex;
+		if (vertexBuffer.has_value()) {
+			tr::window().graphics().setVertexBuffer(*vertexBuffer, baseVertex * sizeof(tr::TintVtx2),
+													sizeof(tr::TintVtx2));
+		}
+		record(GraphicsCall::Type::BIND_VERTEX_BUFFER, baseVertex * sizeof(tr::TintVtx2));
+	}
+	if (bound.indexBuffer != &indexBuffer) {
+		bound.indexBuffer = &indexBuffer;
+		if (indexBuffer.has_value()) {
+			tr::window().graphics().setIndexBuffer(*indexBuffer);
+		}
+		record(GraphicsCall::Type::BIND_INDEX_BUFFER);
+	}
+}
+
+void tre::Renderer2D::drawIndexed(std::size_t offset, std::size_t indices, std::size_t vertices)
+{
+	if (!nullGraphics()) {
+		tr::window().graphics().drawIndexed(tr::Primitive::TRIS, offset, indices);
+	}
+	record(GraphicsCall::Type::DRAW_INDEXED, offset, indices);
+	++_stats.drawCalls;
+	_stats.vertices += vertices;
+	_stats.indices += indices;
+}
+
+tre::Renderer2D::TimestampQueries::~TimestampQueries() noexcept
+{
+	glDeleteQueries(GLsizei(_queries.size()), _queries.data());
+}
+
+tre::Renderer2D::TimestampQueries& tre::Renderer2D::TimestampQueries::operator=(TimestampQueries&& r) noexcept
+{
+	std::swap(_queries, r._queries);
+	return *this;
+}
+
+std::size_t tre::Renderer2D::TimestampQueries::size() const noexcept
+{
+	return _queries.size();
+}
+
+void tre::Renderer2D::TimestampQueries::reserve(std::size_t size)
+{
+	if (_queries.size() < size) {
+		const auto oldSize{_queries.size()};
+		_queries.resize(size);
+		glGenQueries(GLsizei(size - oldSize), _queries.data() + oldSize);
+	}
+}
+
+void tre::Renderer2D::TimestampQueries::recordTimestamp(std::size_t query) noexcept
+{
+	assert(query < _queries.size());
+	glQueryCounter(_queries[query], GL_TIMESTAMP);
+}
+
+bool tre::Renderer2D::TimestampQueries::available(std::size_t query) const noexcept
+{
+	assert(query < _queries.size());
+	GLint available;
+	glGetQueryObjectiv(_queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+	return available;
+}
+
+std::uint64_t tre::Renderer2D::TimestampQueries::result(std::size_t query) const noexcept
+{
+	assert(query < _queries.size());
+	GLuint64 result;
+	glGetQueryObjectui64v(_queries[query], GL_QUERY_RESULT, &result);
+	return result;
+}
+
+tre::Renderer2D::IndirectCommandBuffer::IndirectCommandBuffer()
+{
+	glCreateBuffers(1, &_buffer);
+}
+
+tre::Renderer2D::IndirectCommandBuffer::IndirectCommandBuffer(IndirectCommandBuffer&& r) noexcept
+	: _buffer{std::exchange(r._buffer, 0)}
+{
+}
+
+tre::Renderer2D::IndirectCommandBuffer::~IndirectCommandBuffer() noexcept
+{
+	glDeleteBuffers(1, &_buffer);
+}
+
+tre::Renderer2D::IndirectCommandBuffer& tre::Renderer2D::IndirectCommandBuffer::operator=(
+	IndirectCommandBuffer&& r) noexcept
+{
+	std::swap(_buffer, r._buffer);
+	return *this;
+}
+
+void tre::Renderer2D::IndirectCommandBuffer::set(std::span<const DrawIndirectCommand> commands) noexcept
+{
+	glNamedBufferData(_buffer, commands.size_bytes(), commands.data(), GL_STREAM_DRAW);
+}
+
+void tre::Renderer2D::IndirectCommandBuffer::bind() const noexcept
+{
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _buffer);
+}
+
+void tre::Renderer2D::IndirectCommandBuffer::draw(std::size_t firstCommand, std::size_t commands) const noexcept
+{
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT,
+								reinterpret_cast<const void*>(firstCommand * sizeof(DrawIndirectCommand)),
+								GLsizei(commands), 0);
+}
+
+void tre::Renderer2D::IndirectCommandBuffer::setLabel(std::string_view label) noexcept
+{
+	glObjectLabel(GL_BUFFER, _buffer, GLsizei(label.size()), label.data());
+}
+
+void tre::Renderer2D::collectGpuTimers()
+{
+	for (auto& frame : _gpuTimerFrames | std::views::filter(&GpuTimerFrame::pending)) {
+		if (frame.queries.available(frame.layers.size() * 2 - 1)) {
+			for (std::size_t i = 0; i < frame.layers.size(); ++i) {
+				const std::uint64_t start{frame.queries.result(i * 2)};
+				const std::uint64_t end{frame.queries.result(i * 2 + 1)};
+				_stats.layerGpuTimes[frame.layers[i]] = tr::Duration{end - start};
+			}
+			frame.pending = false;
+		}
+	}
+}
+
+void tre::Renderer2D::drawLayer(const PreparedLayer& layer, const glm::mat4& transform, BoundState& bound)
+{
+	usePipeline(false);
+	setDrawState(bound, layer.texture, layer.sampler, layer.blendMode);
+	setTransform(bound, transform);
+
+	const auto& vertexBuffer{layer.retained != nullptr ? layer.retained->vertexBuffer : _vertexBuffer};
+	const auto& indexBuffer{layer.retained != nullptr ? layer.retained->indexBuffer : _indexBuffer};
+	const auto& draws{layer.retained != nullptr ? layer.retained->draws : _draws};
+	for (auto& draw : std::span{draws}.subspan(layer.firstDraw, layer.draws)) {
+		bindBuffers(bound, vertexBuffer, draw.baseVertex,
+					draw.type == Draw::Type::MESHES ? indexBuffer : _sharedIndexBuffer);
+		drawIndexed(draw.offset, draw.indices, draw.vertices);
+	}
+}
+
+std::size_t tre::Renderer2D::drawLayersIndirect(std::size_t firstLayer, const glm::mat4& viewTransform,
+												BoundState& bound)
+{
+	const auto& first{_preparedLayers[firstLayer]};
+	const auto  compatible{[&](const PreparedLayer& layer) {
+        return (layer.retained == nullptr || !layer.retained->cache.has_value()) && layer.texture == first.texture &&
+               layer.sampler == first.sampler && layer.blendMode == first.blendMode;
+    }};
+	std::size_t endLayer{firstLayer + 1};
+	while (endLayer < _preparedLayers.size() && compatible(_preparedLayers[endLayer])) {
+		++endLayer;
+	}
+	if (endLayer - firstLayer == 1) {
+		drawLayer(first, viewTransform * first.transform, bound);
+		return endLayer;
+	}
+
+	auto& multiDraw{*_multiDraw};
+	multiDraw.commands.clear();
+	multiDraw.transforms.clear();
+	multiDraw.calls.clear();
+	for (auto& layer : std::span{_preparedLayers}.subspan(firstLayer, endLayer - firstLayer)) {
+		const auto& vertexBuffer{layer.retained != nullptr ? layer.retained->vertexBuffer : _vertexBuffer};
+		const auto& indexBuffer{layer.retained != nullptr ? layer.retained->indexBuffer : _indexBuffer};
+		const auto& draws{layer.retained != nullptr ? layer.retained->draws : _draws};
+		for (auto& draw : std::span{draws}.subspan(layer.firstDraw, layer.draws)) {
+			// Consecutive draws from the same buffers are merged into a single call.
+			const auto* drawIndexBuffer{draw.type == Draw::Type::MESHES ? &indexBuffer : &_sharedIndexBuffer};
+			if (multiDraw.calls.empty() || multiDraw.calls.back().vertexBuffer != &vertexBuffer ||
+				multiDraw.calls.back().indexBuffer != drawIndexBuffer) {
+				multiDraw.calls.push_back({&vertexBuffer, drawIndexBuffer, multiDraw.commands.size(), 0, 0, 0});
+			}
+			multiDraw.commands.push_back({std::uint32_t(draw.indices), 1, std::uint32_t(draw.offset),
+										  std::int32_t(draw.baseVertex), 0});
+			multiDraw.transforms.push_back(viewTransform * layer.transform);
+			++multiDraw.calls.back().commands;
+			multiDraw.calls.back().vertices += draw.vertices;
+			multiDraw.calls.back().indices += draw.indices;
+		}
+	}
+
+	multiDraw.commandBuffer.set(multiDraw.commands);
+	if (multiDraw.transformBuffer.arrayCapacity() < multiDraw.transforms.size() * sizeof(glm::mat4)) {
+		const auto newCapacity{std::bit_ceil(multiDraw.transforms.size() * sizeof(glm::mat4))};
+		multiDraw.transformBuffer = tr::ShaderBuffer{0, newCapacity, tr::ShaderBuffer::Access::WRITE_ONLY};
+#ifndef NDEBUG
+		multiDraw.transformBuffer.setLabel("tre::Renderer2D Multi-Draw Transform Buffer");
+#endif
+	}
+	multiDraw.transformBuffer.setArray(tr::rangeBytes(multiDraw.transforms));
+	_stats.uploadedBytes +=
+		multiDraw.commands.size() * sizeof(DrawIndirectCommand) + multiDraw.transforms.size() * sizeof(glm::mat4);
+
+	usePipeline(true);
+	setDrawState(bound, first.texture, first.sampler, first.blendMode);
+	multiDraw.pipeline.vertexShader().setStorageBuffer(0, multiDraw.transformBuffer);
+	multiDraw.commandBuffer.bind();
+	for (auto& call : multiDraw.calls) {
+		// The base vertex is part of the commands, so the vertex buffer is bound without an offset.
+		bindBuffers(bound, *call.vertexBuffer, 0, *call.indexBuffer);
+		multiDraw.pipeline.vertexShader().setUniform(0, int(call.firstCommand));
+		multiDraw.commandBuffer.draw(call.firstCommand, call.commands);
+		++_stats.drawCalls;
+		_stats.vertices += call.vertices;
+		_stats.indices += call.indices;
+	}
+	return endLayer;
+}
+
+void tre::Renderer2D::drawCachedLayer(const PreparedLayer& layer, const RenderView& view,
+									  const tr::RectI2& scissorBox, const glm::mat4& transform, BoundState& bound)
+{
+	auto&      cache{*layer.retained->cache};
+	const auto size{view.viewport().size};
+	if (cache.dirty || !cache.texture.has_value() || cache.texture->size() != size || cache.transform != transform) {
+		if (!cache.texture.has_value() || cache.texture->size() != size) {
+			// The texture is replaced in place, so any cached binding of the old one is stale.
+			graphicsState().invalidate();
+			bound = {};
+			cache.texture.emplace(size, tr::NO_MIPMAPS, tr::TextureFormat::RGBA8);
+			cache.framebuffer.attach(*cache.texture, tr::Framebuffer::Slot::COLOR0);
+		}
+		// The layer is drawn with a blending mode that leaves the cache premultiplied, starting from transparent
+		// black, so that compositing it blends the alpha of every primitive once.
+		PreparedLayer cacheLayer{layer};
+		cacheLayer.blendMode = *cacheBlendMode(layer.blendMode);
+		RenderView{cache.framebuffer}.use();
+		cache.framebuffer.clear({0, 0, 0, 0});
+		drawLayer(cacheLayer, transform, bound);
+		view.use(scissorBox);
+		cache.transform = transform;
+		cache.dirty     = false;
+	}
+
+	usePipeline(false);
+	setDrawState(bound, &*cache.texture, &nearestNeighborSampler(), CACHE_COMPOSITE_BLENDING);
+	setTransform(bound, glm::mat4{1});
+	bindBuffers(bound, _cacheQuadBuffer, 0, _sharedIndexBuffer);
+	drawIndexed(0, 6, 4);
+}
+
+std::optional<tr::RectI2> tre::Renderer2D::findDirtyRect(const RenderView& view, const glm::mat4& viewTransform)
 {
-	if (std::ranges::all_of(_layers, [](auto& layer) { return layer.second.primitives.empty(); })) {
+	auto&            tracking{*_dirtyRects};
+	const glm::ivec2 size{view.viewport().size};
+
+	tracking.frame.clear();
+	for (auto& layer : _preparedLayers) {
+		const auto transform{viewTransform * layer.transform};
+		const auto stateHash{combineHashes(
+			combineHashes(hashBytes(std::span{&layer.texture, 1}), hashBytes(std::span{&layer.sampler, 1})),
+			combineHashes(hashBytes(std::span{&transform, 1}), hashBytes(std::span{&layer.blendMode, 1})))};
+		// Projects a layer space bounding box into view pixels, padded by a pixel to account for rasterization.
+		const auto project{[&](const tr::RectF2& bounds) {
+			glm::vec2 min{std::numeric_limits<float>::max()};
+			glm::vec2 max{std::numeric_limits<float>::lowest()};
+			for (glm::vec2 corner : {bounds.tl, bounds.tl + glm::vec2{bounds.size.x, 0},
+									 bounds.tl + glm::vec2{0, bounds.size.y}, bounds.tl + bounds.size}) {
+				const glm::vec4 clip{transform * glm::vec4{corner, 0, 1}};
+				min = glm::min(min, glm::vec2{clip} / clip.w);
+				max = glm::max(max, glm::vec2{clip} / clip.w);
+			}
+			const glm::ivec2 tl{glm::clamp(glm::ivec2{glm::floor((min + 1.0f) / 2.0f * glm::vec2{size})} - 1,
+										   glm::ivec2{0}, size)};
+			const glm::ivec2 br{glm::clamp(glm::ivec2{glm::ceil((max + 1.0f) / 2.0f * glm::vec2{size})} + 1,
+										   glm::ivec2{0}, size)};
+			return tr::RectI2{tl, br - tl};
+		}};
+
+		const auto& signatures{layer.retained != nullptr ? layer.retained->signatures : _signatures};
+		for (auto& signature : std::span{signatures}.subspan(layer.firstSignature, layer.signatures)) {
+			tracking.frame.push_back({combineHashes(stateHash, signature.hash), project(signature.bounds)});
+		}
+	}
+
+	// Extends a rectangle to cover another, ignoring empty rectangles.
+	const auto extend{[](tr::RectI2& rect, const tr::RectI2& other) {
+		if (other.size.x <= 0 || other.size.y <= 0) {
+			return;
+		}
+		if (rect.size.x <= 0 || rect.size.y <= 0) {
+			rect = other;
+			return;
+		}
+		const glm::ivec2 min{glm::min(rect.tl, other.tl)};
+		const glm::ivec2 max{glm::max(rect.tl + rect.size, other.tl + other.size)};
+		rect = {min, max - min};
+	}};
+
+	auto       it{std::ranges::find(tracking.views, view, &ViewTracking::view)};
+	tr::RectI2 changed{};
+	if (it == tracking.views.end()) {
+		// None of the buffers of a newly tracked view hold a known frame.
+		const tr::RectI2 full{glm::ivec2{}, size};
+		changed = full;
+		tracking.views.push_back({view, {}, std::vector<tr::RectI2>(tracking.bufferCount - 1, full)});
+		it = std::prev(tracking.views.end());
+	}
+	else {
+		const auto& lastFrame{it->lastFrame};
+		// Primitives are compared in drawing order, as reordering them can change the result of blending.
+		for (std::size_t i = 0; i < std::max(tracking.frame.size(), lastFrame.size()); ++i) {
+			if (i >= lastFrame.size()) {
+				extend(changed, tracking.frame[i].rect);
+			}
+			else if (i >= tracking.frame.size()) {
+				extend(changed, lastFrame[i].rect);
+			}
+			else if (tracking.frame[i] != lastFrame[i]) {
+				extend(changed, tracking.frame[i].rect);
+				extend(changed, lastFrame[i].rect);
+			}
+		}
+	}
+
+	// The buffer being drawn to holds the frame drawn bufferCount frames ago, so everything that changed since then has
+	// to be redrawn.
+	tr::RectI2 dirty{changed};
+	for (const tr::RectI2& rect : it->changes) {
+		extend(dirty, rect);
+	}
+	if (!it->changes.empty()) {
+		it->changes.erase(it->changes.begin());
+		it->changes.push_back(changed);
+	}
+	std::swap(tracking.frame, it->lastFrame);
+
+	if (dirty.size.x <= 0 || dirty.size.y <= 0) {
+		return std::nullopt;
+	}
+	return dirty;
+}
+
+void tre::Renderer2D::drawPrepared(const RenderView& view, const glm::mat4& viewTransform)
+{
+	assert(!nullGraphics());
+
+	tr::RectI2 scissorBox{{}, view.viewport().size};
+	if (_dirtyRects.has_value()) {
+		const auto dirtyRect{findDirtyRect(view, viewTransform)};
+		if (!dirtyRect.has_value()) {
+			return;
+		}
+		scissorBox = *dirtyRect;
+		view.use(scissorBox);
+		view.framebuffer().clear(_dirtyRects->clearColor);
+	}
+	if (_preparedLayers.empty()) {
 		return;
 	}
 
 	setupContext();
-	target.use();
+	view.use(scissorBox);
 
-	const std::ranges::subrange    range{_layers.begin(), _layers.lower_bound(maxPriority)};
-	const std::vector<std::size_t> indexOffsets{uploadToGraphicsBuffers(range.end())};
-	auto                           it{indexOffsets.begin()};
-	for (auto& layer : range | std::views::values) {
-		auto indices{*std::next(it) - *it};
-		if (indices == 0) {
-			++it;
+	// Draws aren't timed if the queries that would be reused are still pending.
+	GpuTimerFrame* timer{nullptr};
+	if (!_gpuTimerFrames.empty() && !_gpuTimerFrames[_gpuTimerFrame].pending) {
+		timer = &_gpuTimerFrames[_gpuTimerFrame];
+		_gpuTimerFrame = (_gpuTimerFrame + 1) % _gpuTimerFrames.size();
+		timer->queries.reserve(_preparedLayers.size() * 2);
+		timer->layers.clear();
+		timer->pending = true;
+	}
+
+	BoundState bound;
+	for (std::size_t i = 0; i < _preparedLayers.size();) {
+		const auto& layer{_preparedLayers[i]};
+		const bool  cached{layer.retained != nullptr && layer.retained->cache.has_value()};
+		if (_multiDraw.has_value() && timer == nullptr && !cached) {
+			i = drawLayersIndirect(i, viewTransform, bound);
 			continue;
 		}
 
-		static const tr::Texture2D* texture{};
-		if (texture != layer.texture && layer.texture != nullptr) {
-			texture = layer.texture;
-			_textureUnit.setTexture(*texture);
+		if (timer != nullptr) {
+			timer->queries.recordTimestamp(timer->layers.size() * 2);
 		}
-		static const tr::Sampler* sampler{};
-		if (sampler != layer.sampler && layer.sampler != nullptr) {
-			sampler = layer.sampler;
-			_textureUnit.setSampler(*sampler);
+		if (cached) {
+			drawCachedLayer(layer, view, scissorBox, viewTransform * layer.transform, bound);
 		}
-		static glm::mat4 transform{};
-		if (transform != layer.transform) {
-			transform = layer.transform;
-			_shaderPipeline.vertexShader().setUniform(0, transform);
+		else {
+			drawLayer(layer, viewTransform * layer.transform, bound);
 		}
-		static tr::BlendMode blendMode{};
-		if (blendMode != layer.blendMode) {
-			blendMode = layer.blendMode;
-			tr::window().graphics().setBlendingMode(blendMode);
+		if (timer != nullptr) {
+			timer->queries.recordTimestamp(timer->layers.size() * 2 + 1);
+			timer->layers.push_back(layer.priority);
 		}
+		++i;
+	}
+}
 
-		tr::window().graphics().drawIndexed(tr::Primitive::TRIS, *it, indices);
-		++it;
+void tre::Renderer2D::drawPrepared(NullGraphics, const glm::mat4& viewTransform)
+{
+	assert(nullGraphics());
+
+	BoundState bound;
+	for (auto& layer : _preparedLayers) {
+		drawLayer(layer, viewTransform * layer.transform, bound);
 	}
 }
 
+void tre::Renderer2D::drawUpToLayer(int maxPriority, const RenderView& target)
+{
+	prepareUpToLayer(maxPriority);
+	drawPrepared(target);
+}
+
 void tre::Renderer2D::draw(const RenderView& view)
 {
 	drawUpToLayer(std::numeric_limits<int>::max(), view);
 }
 
+const tre::Renderer2D::Stats& tre::Renderer2D::stats() const noexcept
+{
+	return _stats;
+}
+
+void tre::Renderer2D::setGpuTimingEnabled(bool enabled)
+{
+	if (nullGraphics()) {
+		return;
+	}
+
+	if (!enabled) {
+		_gpuTimerFrames.clear();
+		_stats.layerGpuTimes.clear();
+	}
+	else if (_gpuTimerFrames.empty()) {
+		_gpuTimerFrames.resize(GPU_TIMER_FRAMES);
+		_gpuTimerFrame = 0;
+	}
+}
+
+void tre::Renderer2D::setMultiDrawIndirectEnabled(bool enabled)
+{
+	if (nullGraphics()) {
+		return;
+	}
+
+	if (!enabled) {
+		if (_multiDraw.has_value()) {
+			_multiDraw.reset();
+			// A pipeline created later may reuse the address of the destroyed one.
+			graphicsState().invalidate();
+		}
+	}
+	else if (!_multiDraw.has_value()) {
+		tr::OwningShaderPipeline pipeline{tr::loadEmbeddedShader(RENDERER_2D_MDI_VERT_SPV, tr::ShaderType::VERTEX),
+										  tr::loadEmbeddedShader(RENDERER_2D_FRAG_SPV, tr::ShaderType::FRAGMENT)};
+		tr::ShaderBuffer         transformBuffer{0, 64 * sizeof(glm::mat4), tr::ShaderBuffer::Access::WRITE_ONLY};
+		_multiDraw.emplace(std::move(pipeline), std::move(transformBuffer));
+#ifndef NDEBUG
+		_multiDraw->pipeline.setLabel("tre::Renderer2D Multi-Draw Pipeline");
+		_multiDraw->pipeline.vertexShader().setLabel("tre::Renderer2D Multi-Draw Vertex Shader");
+		_multiDraw->pipeline.fragmentShader().setLabel("tre::Renderer2D Multi-Draw Fragment Shader");
+		_multiDraw->transformBuffer.setLabel("tre::Renderer2D Multi-Draw Transform Buffer");
+		_multiDraw->commandBuffer.setLabel("tre::Renderer2D Multi-Draw Command Buffer");
+#endif
+	}
+}
+
+const std::vector<tre::GraphicsCall>& tre::Renderer2D::recordedCalls() const noexcept
+{
+	assert(nullGraphics());
+	return *_recordedCalls;
+}
+
+void tre::Renderer2D::clearRecordedCalls() noexcept
+{
+	assert(nullGraphics());
+	_recordedCalls->clear();
+}
+
+tre::Renderer2D::FrameCapture tre::Renderer2D::captureFrame(int maxLayer) const
+{
+	FrameCapture                                  capture;
+	std::unordered_map<const void*, std::int32_t> textures;
+	std::unordered_map<const void*, std::int32_t> samplers;
+	const auto index{[](std::unordered_map<const void*, std::int32_t>& table, const void* ptr) {
+		return ptr == nullptr ? -1 : table.emplace(ptr, std::int32_t(table.size())).first->second;
+	}};
+
+	for (auto& [priority, layer] : std::ranges::subrange{_layers.begin(), _layers.lower_bound(maxLayer)}) {
+		capture._layers.push_back({priority, index(textures, layer.texture), index(samplers, layer.sampler),
+								   layer.transform, layer.blendMode, layer.retained.has_value(), layer.primitives});
+	}
+	capture._textures = textures.size();
+	capture._samplers = samplers.size();
+	return capture;
+}
+
+void tre::Renderer2D::replayFrame(const FrameCapture& capture, std::span<const tr::Texture2D* const> textures,
+								  std::span<const tr::Sampler* const> samplers)
+{
+	assert(nullGraphics() || (textures.size() >= capture.textureCount() && samplers.size() >= capture.samplerCount()));
+
+	for (auto& captured : capture._layers) {
+		const auto texture{std::size_t(captured.texture) < textures.size() ? textures[captured.texture] : nullptr};
+		const auto sampler{std::size_t(captured.sampler) < samplers.size() ? samplers[captured.sampler] : nullptr};
+		auto&      layer{_layers[captured.priority]};
+		layer.texture   = texture;
+		layer.sampler   = sampler;
+		layer.transform = captured.transform;
+		layer.blendMode = captured.blendMode;
+		setLayerRetained(captured.priority, captured.retained);
+		if (captured.retained) {
+			invalidateLayer(captured.priority);
+		}
+		layer.primitives.append(captured.primitives);
+	}
+}
+
+tre::Renderer2D::FrameCapture::FrameCapture(std::istream& is)
+{
+	if (readBinary<std::array<char, 8>>(is) != FRAME_CAPTURE_MAGIC) {
+		throw FrameCaptureDecodingError{"Invalid frame capture magic."};
+	}
+	if (readBinary<std::uint32_t>(is) != FRAME_CAPTURE_VERSION) {
+		throw FrameCaptureDecodingError{"Unsupported frame capture version."};
+	}
+
+	_textures = readBinary<std::uint32_t>(is);
+	_samplers = readBinary<std::uint32_t>(is);
+	// Layers and primitives are only allocated as they're read, and counts are validated before anything is allocated
+	// for them, so that a corrupt capture fails to decode instead of exhausting memory.
+	const auto                 layers{readBinary<std::uint32_t>(is)};
+	std::vector<tr::TintVtx2>  vertices;
+	std::vector<std::uint16_t> indices;
+	for (std::uint32_t i = 0; i < layers; ++i) {
+		auto& layer{_layers.emplace_back()};
+		layer.priority = readBinary<std::int32_t>(is);
+		layer.texture  = readBinary<std::int32_t>(is);
+		layer.sampler  = readBinary<std::int32_t>(is);
+		if (layer.texture < -1 || layer.texture >= std::int64_t(_textures) || layer.sampler < -1 ||
+			layer.sampler >= std::int64_t(_samplers) || (layer.texture == -1) != (layer.sampler == -1)) {
+			throw FrameCaptureDecodingError{"Invalid frame capture texture or sampler."};
+		}
+		layer.transform = readBinary<glm::mat4>(is);
+		layer.blendMode = readBinary<tr::BlendMode>(is);
+		if (!validBlendMode(layer.blendMode)) {
+			throw FrameCaptureDecodingError{"Invalid frame capture blending mode."};
+		}
+		const auto retained{readBinary<std::uint8_t>(is)};
+		if (retained > 1) {
+			throw FrameCaptureDecodingError{"Invalid frame capture layer retention flag."};
+		}
+		layer.retained = retained;
+
+		const auto primitives{readBinary<std::uint32_t>(is)};
+		for (std::uint32_t j = 0; j < primitives; ++j) {
+			const auto type{CapturedPrimitive{readBinary<std::uint8_t>(is)}};
+			const auto vertexCount{readBinary<std::uint32_t>(is)};
+			switch (type) {
+			case CapturedPrimitive::QUAD:
+				if (vertexCount != 4) {
+					throw FrameCaptureDecodingError{"Invalid frame capture quad."};
+				}
+				break;
+			case CapturedPrimitive::FAN:
+			case CapturedPrimitive::MESH:
+				if (vertexCount < 3 || vertexCount > MAX_DRAW_VERTICES) {
+					throw FrameCaptureDecodingError{"Invalid frame capture fan or mesh."};
+				}
+				break;
+			default:
+				throw FrameCaptureDecodingError{"Invalid frame capture primitive type."};
+			}
+			readBinary(is, vertices, vertexCount);
+			const auto indexCount{readBinary<std::uint32_t>(is)};
+			if (type == CapturedPrimitive::MESH ? indexCount == 0 || indexCount % 3 != 0 : indexCount != 0) {
+				throw FrameCaptureDecodingError{"Invalid frame capture index count."};
+			}
+			readBinary(is, indices, indexCount);
+
+			switch (type) {
+			case CapturedPrimitive::QUAD:
+				std::ranges::copy(vertices, std::get<TextureQuad>(layer.primitives.primitives.emplace_back()).begin());
+				break;
+			case CapturedPrimitive::FAN:
+				std::ranges::copy(vertices, layer.primitives.addFan(vertices.size()).begin());
+				break;
+			case CapturedPrimitive::MESH: {
+				if (std::ranges::any_of(indices, [&](auto index) { return index >= vertices.size(); })) {
+					throw FrameCaptureDecodingError{"Invalid frame capture mesh."};
+				}
+				const TextureMeshSpans mesh{layer.primitives.addMesh(vertices.size(), indices.size())};
+				std::ranges::copy(vertices, mesh.vertices.begin());
+				std::ranges::copy(indices, mesh.indices.begin());
+				break;
+			}
+			}
+		}
+	}
+}
+
+void tre::Renderer2D::FrameCapture::save(std::ostream& os) const
+{
+	writeBinary(os, FRAME_CAPTURE_MAGIC);
+	writeBinary(os, FRAME_CAPTURE_VERSION);
+	writeBinary(os, std::uint32_t(_textures));
+	writeBinary(os, std::uint32_t(_samplers));
+	writeBinary(os, std::uint32_t(_layers.size()));
+	for (auto& layer : _layers) {
+		writeBinary(os, std::int32_t(layer.priority));
+		writeBinary(os, layer.texture);
+		writeBinary(os, layer.sampler);
+		writeBinary(os, layer.transform);
+		writeBinary(os, layer.blendMode);
+		writeBinary(os, std::uint8_t(layer.retained));
+		writeBinary(os, std::uint32_t(layer.primitives.size()));
+		for (auto& primitive : layer.primitives.primitives) {
+			std::visit(tr::Overloaded{[&](const TextureQuad& quad) {
+										  writeBinary(os, CapturedPrimitive::QUAD);
+										  writePrimitive(os, quad, {});
+									  },
+									  [&](const TextureMesh& mesh) {
+										  writeBinary(os, CapturedPrimitive::MESH);
+										  writePrimitive(os, layer.primitives.meshVertices(mesh),
+														 layer.primitives.meshIndices(mesh));
+									  }},
+					   primitive);
+		}
+	}
+}
+
+std::size_t tre::Renderer2D::FrameCapture::textureCount() const noexcept
+{
+	return _textures;
+}
+
+std::size_t tre::Renderer2D::FrameCapture::samplerCount() const noexcept
+{
+	return _samplers;
+}
+
+std::size_t tre::Renderer2D::FrameCapture::primitiveCount() const noexcept
+{
+	std::size_t primitives{0};
+	for (auto& layer : _layers) {
+		primitives += layer.primitives.size();
+	}
+	return primitives;
+}
+
+tre::FrameCaptureDecodingError::FrameCaptureDecodingError(const char* description) noexcept
+	: _description{description}
+{
+}
+
+const char* tre::FrameCaptureDecodingError::what() const noexcept
+{
+	return _description;
+}
+
 bool tre::renderer2DActive() noexcept
 {
 	return _renderer2D != nullptr;
@@ -1,5 +1,6 @@
 #include "../include/tre/text.hpp"
 #include <numeric>
+#include <unordered_map>
 
 namespace tre {
 	struct TextPart {
@@ -17,8 +18,24 @@ namespace tre {
 		tr::RGBA8             curTextColor;
 		std::span<tr::RGBA8>  textColors;
 		HorizontalAlign       alignment;
+		// Set when only measuring, in which case no text parts are rendered.
+		std::vector<float>* lineWidths{nullptr};
 	};
 
+	// Memoized multistyle text metrics.
+	struct MemoizedTextMetrics {
+		TextMetrics        metrics;
+		std::vector<float> lineWidths;
+	};
+
+	// The maximum number of memoized text metrics. The memo is cleared when it is exceeded.
+	constexpr std::size_t MAX_MEMOIZED_TEXT_METRICS{1024};
+
+	// Memoized multistyle text metrics keyed by the measurement parameters and text.
+	std::unordered_map<std::string, MemoizedTextMetrics> _textMetrics;
+	// Scratch key storage, reused to avoid allocating on every lookup.
+	std::string _textMetricsKey;
+
 	// Renders outlined text.
 	tr::Bitmap renderOutlinedText(const char* text, const MultistyleTextContext& ctx);
 
@@ -30,13 +47,15 @@ namespace tre {
 	void createTextPart(std::string::iterator end, std::string::iterator stringEnd, std::string_view fit,
 						MultistyleTextContext& ctx);
 
+	// Adds the width of a section of the text to the width of its line.
+	void measureTextPart(int width, MultistyleTextContext& ctx);
+
 	// Handles the rendering of text parts for a block of text with a single consistent style.
 	std::string_view::iterator handleTextBlock(std::string_view::iterator start, std::string_view::iterator textEnd,
 											   MultistyleTextContext& ctx);
 
-	// Handles the parsing of escaped control sequences and sets the context state accordingly.
-	std::string_view::iterator handleControlSequence(std::string_view::iterator start,
-													 std::string_view::iterator textEnd, MultistyleTextContext& ctx);
+	// Sets the context state to the style of a rich text run.
+	void applyRunStyle(const RichText::Run& run, MultistyleTextContext& ctx);
 
 	// Calculates the starting X offset for a text part.
 	int calculateStartingX(std::vector<TextPart>::iterator it, std::vector<TextPart>::iterator lineEnd,
@@ -47,8 +66,117 @@ namespace tre {
 
 	// Stitches together the final output bitmap.
 	tr::Bitmap createBitmap(MultistyleTextContext& ctx);
+
+	// Starts a metrics memo key with the measurement parameters.
+	void startTextMetricsKey(const tr::TTFont& font, int size, glm::uvec2 dpi, int maxWidth, int outline);
+
+	// Appends the raw bytes of a value to the metrics memo key.
+	template <class T> void appendTextMetricsKey(const T& value);
+
+	// Measures text into a memo entry.
+	void measureRichText(MemoizedTextMetrics& out, const RichText& text, tr::TTFont& font, int maxWidth,
+						 TextOutline outline);
+
+	// Measures text and memoizes the result under the current memo key.
+	const MemoizedTextMetrics& memoizeTextMetrics(const RichText& text, tr::TTFont& font, int size, glm::uvec2 dpi,
+												  int maxWidth, TextOutline outline);
+
+	// Copies memoized metrics out, returning them.
+	TextMetrics copyTextMetrics(std::span<float> lineWidths, const MemoizedTextMetrics& memo) noexcept;
 } // namespace tre
 
+tre::RichText::RichText(std::string_view formatted)
+{
+	Run  run{0, 0, DEFAULT_COLOR, false, false, false, false};
+	bool runColorSet{false};
+	// Ends the current run before its style is changed. Empty runs are dropped, unless they set a color that the
+	// following run may fall back to because its color index is out of range.
+	const auto endRun{[&](bool colorChange) {
+        if (_text.size() != run.begin || (colorChange && runColorSet)) {
+            run.end = _text.size();
+            _runs.push_back(run);
+            run.begin   = _text.size();
+            runColorSet = false;
+        }
+    }};
+	// Skips the continuation bytes of a multi-byte character.
+	const auto skipContinuation{[&](std::size_t& i) {
+        while (i + 1 < formatted.size() && (formatted[i + 1] & 0xC0) == 0x80) {
+            ++i;
+        }
+    }};
+
+	for (std::size_t i = 0; i < formatted.size(); ++i) {
+		if (formatted[i] != '\\') {
+			_text.push_back(formatted[i]);
+			continue;
+		}
+		if (++i == formatted.size()) {
+			break;
+		}
+
+		switch (formatted[i]) {
+		case '\\':
+			_text.push_back('\\');
+			break;
+		case '!':
+			endRun(true);
+			run.color   = DEFAULT_COLOR;
+			runColorSet = true;
+			break;
+		case 'c':
+			if (++i == formatted.size()) {
+				break;
+			}
+			if (formatted[i] >= '0' && formatted[i] <= '9') {
+				endRun(true);
+				run.color   = formatted[i] - '0';
+				runColorSet = true;
+			}
+			skipContinuation(i);
+			break;
+		case 'b':
+			endRun(false);
+			run.bold = !run.bold;
+			break;
+		case 'i':
+			endRun(false);
+			run.italic = !run.italic;
+			break;
+		case 'u':
+			endRun(false);
+			run.underline = !run.underline;
+			break;
+		case 's':
+			endRun(false);
+			run.strikethrough = !run.strikethrough;
+			break;
+		default:
+			skipContinuation(i);
+			break;
+		}
+	}
+	if (_text.size() != run.begin) {
+		run.end = _text.size();
+		_runs.push_back(run);
+	}
+}
+
+std::string_view tre::RichText::text() const noexcept
+{
+	return _text;
+}
+
+std::string_view tre::RichText::text(const Run& run) const noexcept
+{
+	return std::string_view{_text}.substr(run.begin, run.end - run.begin);
+}
+
+std::span<const tre::RichText::Run> tre::RichText::runs() const noexcept
+{
+	return _runs;
+}
+
 tr::Bitmap tre::renderOutlinedText(const char* text, const MultistyleTextContext& ctx)
 {
 	ctx.font.setOutline(0);
@@ -110,14 +238,19 @@ void tre::createTextPart(std::string::iterator end, std::string::iterator string
 std::string_view::iterator tre::handleTextBlock(std::string_view::iterator start, std::string_view::iterator textEnd,
 												MultistyleTextContext& ctx)
 {
-	const auto  end{std::ranges::find_first_of(std::ranges::subrange{std::next(start), textEnd}, "\n\\")};
+	const auto  end{std::ranges::find(std::ranges::subrange{start, textEnd}, '\n')};
 	std::string copy{start, end};
 	for (auto it = copy.begin(); it != copy.end();) {
 		auto fit{ctx.font.measure(std::to_address(it), ctx.lineLeft)};
 		if (!adjustFit(fit.text, it, copy.end(), ctx)) {
 			continue;
 		}
-		createTextPart(it, copy.end(), fit.text, ctx);
+		if (ctx.lineWidths != nullptr) {
+			measureTextPart(fit.width, ctx);
+		}
+		else {
+			createTextPart(it, copy.end(), fit.text, ctx);
+		}
 		ctx.lineLeft -= fit.width - 2 * ctx.outline.thickness;
 		if (ctx.lineLeft < 0) {
 			++ctx.line;
@@ -127,40 +260,40 @@ std::string_view::iterator tre::handleTextBlock(std::string_view::iterator start
 	return end;
 }
 
-std::string_view::iterator tre::handleControlSequence(std::string_view::iterator start,
-													  std::string_view::iterator textEnd, MultistyleTextContext& ctx)
+void tre::measureTextPart(int width, MultistyleTextContext& ctx)
 {
-	if (start == textEnd) {
-		return start;
+	if (ctx.lineWidths->size() <= std::size_t(ctx.line)) {
+		ctx.lineWidths->resize(ctx.line + 1, 0.0f);
 	}
+	(*ctx.lineWidths)[ctx.line] += width - 2 * ctx.outline.thickness;
+}
 
-	switch (*start) {
-	case '\\':
-		return handleTextBlock(start, textEnd, ctx);
-	case '!':
-		ctx.curTextColor = ctx.textColors[0];
-		break;
-	case 'c':
-		if (std::next(start) != textEnd && std::isdigit(*++start) && *start - '0' < ctx.textColors.size()) {
-			ctx.curTextColor = ctx.textColors[*start - '0'];
+void tre::applyRunStyle(const RichText::Run& run, MultistyleTextContext& ctx)
+{
+	// Measuring contexts have no colors.
+	if (!ctx.textColors.empty()) {
+		if (run.color == RichText::DEFAULT_COLOR) {
+			ctx.curTextColor = ctx.textColors[0];
+		}
+		else if (run.color < ctx.textColors.size()) {
+			ctx.curTextColor = ctx.textColors[run.color];
 		}
-		break;
-	case 'b':
-		ctx.font.setStyle(ctx.font.style() ^ tr::TTFont::Style::BOLD);
-		break;
-	case 'i':
-		ctx.font.setStyle(ctx.font.style() ^ tr::TTFont::Style::ITALIC);
-		break;
-	case 's':
-		ctx.font.setStyle(ctx.font.style() ^ tr::TTFont::Style::STRIKETHROUGH);
-		break;
-	case 'u':
-		ctx.font.setStyle(ctx.font.style() ^ tr::TTFont::Style::UNDERLINE);
-		break;
-	default:
-		break;
 	}
-	return std::next(start);
+
+	tr::TTFont::Style style{tr::TTFont::Style::NORMAL};
+	if (run.bold) {
+		style = style ^ tr::TTFont::Style::BOLD;
+	}
+	if (run.italic) {
+		style = style ^ tr::TTFont::Style::ITALIC;
+	}
+	if (run.strikethrough) {
+		style = style ^ tr::TTFont::Style::STRIKETHROUGH;
+	}
+	if (run.underline) {
+		style = style ^ tr::TTFont::Style::UNDERLINE;
+	}
+	ctx.font.setStyle(style);
 }
 
 int tre::calculateStartingX(std::vector<TextPart>::iterator it, std::vector<TextPart>::iterator lineEnd,
@@ -204,25 +337,135 @@ tr::Bitmap tre::renderMultistyleText(std::string_view text, tr::TTFont& font, in
 									 HorizontalAlign alignment, std::span<tr::RGBA8> textColors, TextOutline outline)
 {
 	assert(!text.empty());
+	return renderMultistyleText(RichText{text}, font, size, dpi, maxWidth, alignment, textColors, outline);
+}
+
+tr::Bitmap tre::renderMultistyleText(const RichText& text, tr::TTFont& font, int size, glm::uvec2 dpi, int maxWidth,
+									 HorizontalAlign alignment, std::span<tr::RGBA8> textColors, TextOutline outline)
+{
 	assert(!textColors.empty());
-	font.setStyle(tr::TTFont::Style::NORMAL);
 	font.setOutline(outline.thickness);
 	font.resize(size, dpi);
 
 	maxWidth = maxWidth * dpi.x / 72;
 	MultistyleTextContext ctx{font, {}, 0, maxWidth, maxWidth, outline, textColors.front(), textColors, alignment};
-	for (auto it = text.begin(); it != text.end();) {
-		if (*it == '\\') {
-			it = handleControlSequence(++it, text.end(), ctx);
-		}
-		else if (*it == '\n') {
-			++ctx.line;
-			ctx.lineLeft = ctx.maxWidth;
-			++it;
-		}
-		else {
-			it = handleTextBlock(it, text.end(), ctx);
+	for (const RichText::Run& run : text.runs()) {
+		applyRunStyle(run, ctx);
+		const std::string_view runText{text.text(run)};
+		for (auto it = runText.begin(); it != runText.end();) {
+			if (*it == '\n') {
+				++ctx.line;
+				ctx.lineLeft = ctx.maxWidth;
+				++it;
+			}
+			else {
+				it = handleTextBlock(it, runText.end(), ctx);
+			}
 		}
 	}
+	// Text solely consisting of control sequences and newlines has nothing to render.
+	if (ctx.parts.empty()) {
+		return tr::Bitmap{{0, 0}, tr::BitmapFormat::ARGB_8888};
+	}
 	return createBitmap(ctx);
+}
+
+void tre::startTextMetricsKey(const tr::TTFont& font, int size, glm::uvec2 dpi, int maxWidth, int outline)
+{
+	_textMetricsKey.clear();
+	appendTextMetricsKey(&font);
+	appendTextMetricsKey(size);
+	appendTextMetricsKey(dpi);
+	appendTextMetricsKey(maxWidth);
+	appendTextMetricsKey(outline);
+}
+
+template <class T> void tre::appendTextMetricsKey(const T& value)
+{
+	_textMetricsKey.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void tre::measureRichText(MemoizedTextMetrics& out, const RichText& text, tr::TTFont& font, int maxWidth,
+						  TextOutline outline)
+{
+	MultistyleTextContext ctx{font, {}, 0, maxWidth, maxWidth, outline, {}, {}, HorizontalAlign::LEFT, &out.lineWidths};
+	for (const RichText::Run& run : text.runs()) {
+		applyRunStyle(run, ctx);
+		const std::string_view runText{text.text(run)};
+		for (auto it = runText.begin(); it != runText.end();) {
+			if (*it == '\n') {
+				++ctx.line;
+				ctx.lineLeft = ctx.maxWidth;
+				++it;
+			}
+			else {
+				it = handleTextBlock(it, runText.end(), ctx);
+			}
+		}
+	}
+
+	// Like the rendered bitmap, trailing empty lines aren't counted.
+	if (!out.lineWidths.empty()) {
+		const glm::vec2 size{std::ranges::max(out.lineWidths), float(out.lineWidths.size() * font.lineSkip())};
+		out.metrics = {out.lineWidths.size(), size + float(2 * outline.thickness)};
+	}
+}
+
+const tre::MemoizedTextMetrics& tre::memoizeTextMetrics(const RichText& text, tr::TTFont& font, int size,
+														 glm::uvec2 dpi, int maxWidth, TextOutline outline)
+{
+	if (_textMetrics.size() >= MAX_MEMOIZED_TEXT_METRICS) {
+		_textMetrics.clear();
+	}
+	MemoizedTextMetrics memo{};
+	font.setOutline(outline.thickness);
+	font.resize(size, dpi);
+	measureRichText(memo, text, font, maxWidth * dpi.x / 72, outline);
+	return _textMetrics.emplace(_textMetricsKey, std::move(memo)).first->second;
+}
+
+tre::TextMetrics tre::copyTextMetrics(std::span<float> lineWidths, const MemoizedTextMetrics& memo) noexcept
+{
+	const std::size_t count{std::min(lineWidths.size(), memo.lineWidths.size())};
+	std::ranges::copy(memo.lineWidths.begin(), memo.lineWidths.begin() + count, lineWidths.begin());
+	return memo.metrics;
+}
+
+tre::TextMetrics tre::measureMultistyleText(std::span<float> lineWidths, std::string_view text, tr::TTFont& font,
+											int size, glm::uvec2 dpi, int maxWidth, TextOutline outline)
+{
+	startTextMetricsKey(font, size, dpi, maxWidth, outline.thickness);
+	_textMetricsKey.push_back('S');
+	_textMetricsKey.append(text);
+
+	const auto it{_textMetrics.find(_textMetricsKey)};
+	if (it != _textMetrics.end()) {
+		return copyTextMetrics(lineWidths, it->second);
+	}
+	return copyTextMetrics(lineWidths, memoizeTextMetrics(RichText{text}, font, size, dpi, maxWidth, outline));
+}
+
+tre::TextMetrics tre::measureMultistyleText(std::span<float> lineWidths, const RichText& text, tr::TTFont& font,
+											int size, glm::uvec2 dpi, int maxWidth, TextOutline outline)
+{
+	startTextMetricsKey(font, size, dpi, maxWidth, outline.thickness);
+	_textMetricsKey.push_back('R');
+	_textMetricsKey.append(text.text());
+	// Colors don't affect measurements, so only the extents and font styles of runs are part of the key.
+	for (const RichText::Run& run : text.runs()) {
+		appendTextMetricsKey(run.begin);
+		appendTextMetricsKey(run.end);
+		_textMetricsKey.push_back(char(run.bold | run.italic << 1 | run.underline << 2 | run.strikethrough << 3));
+	}
+
+	const auto it{_textMetrics.find(_textMetricsKey)};
+	if (it != _textMetrics.end()) {
+		return copyTextMetrics(lineWidths, it->second);
+	}
+	return copyTextMetrics(lineWidths, memoizeTextMetrics(text, font, size, dpi, maxWidth, outline));
+}
+
+void tre::clearMultistyleTextMetrics() noexcept
+{
+	_textMetrics.clear();
 }
\ No newline at end of file
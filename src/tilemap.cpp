@@ -0,0 +1,178 @@
+#include "../include/tre/tilemap.hpp"
+#include "../include/tre/graphics_state.hpp"
+#include "../resources/renderer_2d.frag.spv.hpp"
+#include "../resources/renderer_2d.vert.spv.hpp"
+
+namespace tre {
+	// Sentinel handle marking an empty tile.
+	constexpr Atlas2D::Handle EMPTY_TILE{std::numeric_limits<std::uint32_t>::max()};
+	constexpr std::size_t     MAX_CHUNK_QUADS{Tilemap::CHUNK_SIZE * Tilemap::CHUNK_SIZE};
+
+	// Creates the indices of a chunk's quads, which are the same for every chunk.
+	std::vector<std::uint16_t> chunkIndices();
+} // namespace tre
+
+std::vector<std::uint16_t> tre::chunkIndices()
+{
+	std::vector<std::uint16_t> indices;
+	indices.reserve(MAX_CHUNK_QUADS * 6);
+	for (std::size_t i = 0; i < MAX_CHUNK_QUADS; ++i) {
+		tr::fillPolygonIndices(std::back_inserter(indices), 4, std::uint16_t(i * 4));
+	}
+	return indices;
+}
+
+tre::Tilemap::Tilemap(const Atlas2D& atlas, glm::ivec2 size, glm::vec2 tileSize)
+	: _shaderPipeline{tr::loadEmbeddedShader(RENDERER_2D_VERT_SPV, tr::ShaderType::VERTEX),
+					  tr::loadEmbeddedShader(RENDERER_2D_FRAG_SPV, tr::ShaderType::FRAGMENT)}
+	, _indexBuffer{chunkIndices()}
+	, _atlas{atlas}
+	, _size{size}
+	, _tileSize{tileSize}
+	, _tiles(std::size_t(size.x) * size.y, EMPTY_TILE)
+{
+	assert(size.x > 0 && size.y > 0);
+
+	const glm::ivec2 chunks{chunkCount()};
+	_chunks.reserve(std::size_t(chunks.x) * chunks.y);
+	for (int i = 0; i < chunks.x * chunks.y; ++i) {
+		_chunks.push_back({tr::VertexBuffer{}, 0, false});
+	}
+	_shaderPipeline.fragmentShader().setUniform(1, _textureUnit);
+
+#ifndef NDEBUG
+	_shaderPipeline.setLabel("tre::Tilemap Pipeline");
+	_shaderPipeline.vertexShader().setLabel("tre::Tilemap Vertex Shader");
+	_shaderPipeline.fragmentShader().setLabel("tre::Tilemap Fragment Shader");
+	_indexBuffer.setLabel("tre::Tilemap Index Buffer");
+	for (auto& chunk : _chunks) {
+		chunk.vertexBuffer.setLabel("tre::Tilemap Chunk Vertex Buffer");
+	}
+#endif
+}
+
+tre::Tilemap::Tilemap(Tilemap&& r) noexcept = default;
+
+tre::Tilemap::~Tilemap() noexcept
+{
+	graphicsState().invalidate();
+}
+
+glm::ivec2 tre::Tilemap::size() const noexcept
+{
+	return _size;
+}
+
+glm::vec2 tre::Tilemap::tileSize() const noexcept
+{
+	return _tileSize;
+}
+
+std::optional<tre::Atlas2D::Handle> tre::Tilemap::tile(glm::ivec2 pos) const noexcept
+{
+	assert(pos.x >= 0 && pos.y >= 0 && pos.x < _size.x && pos.y < _size.y);
+	const Atlas2D::Handle tile{_tiles[std::size_t(pos.y) * _size.x + pos.x]};
+	return tile != EMPTY_TILE ? std::optional{tile} : std::nullopt;
+}
+
+void tre::Tilemap::setTile(glm::ivec2 pos, std::optional<Atlas2D::Handle> tile) noexcept
+{
+	assert(pos.x >= 0 && pos.y >= 0 && pos.x < _size.x && pos.y < _size.y);
+	Atlas2D::Handle& stored{_tiles[std::size_t(pos.y) * _size.x + pos.x]};
+	const auto       newTile{tile.value_or(EMPTY_TILE)};
+	if (stored != newTile) {
+		stored = newTile;
+		const glm::ivec2 chunk{pos / CHUNK_SIZE};
+		_chunks[std::size_t(chunk.y) * chunkCount().x + chunk.x].dirty = true;
+	}
+}
+
+glm::ivec2 tre::Tilemap::chunkCount() const noexcept
+{
+	return (_size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+}
+
+void tre::Tilemap::rebuildChunk(glm::ivec2 chunk)
+{
+	const glm::ivec2 first{chunk * CHUNK_SIZE};
+	const glm::ivec2 last{glm::min(first + CHUNK_SIZE, _size)};
+
+	_vertices.clear();
+	for (int y = first.y; y < last.y; ++y) {
+		for (int x = first.x; x < last.x; ++x) {
+			const Atlas2D::Handle tile{_tiles[std::size_t(y) * _size.x + x]};
+			if (tile == EMPTY_TILE) {
+				continue;
+			}
+			const tr::RectF2& uv{_atlas.get()[tile]};
+			std::array<tr::TintVtx2, 4> quad;
+			tr::fillRectVertices((quad | tr::positions).begin(), glm::vec2{x, y} * _tileSize, _tileSize);
+			tr::fillRectVertices((quad | tr::uvs).begin(), uv.tl, uv.size);
+			std::ranges::fill(quad | tr::colors, tr::RGBA8{255, 255, 255, 255});
+			_vertices.insert(_vertices.end(), quad.begin(), quad.end());
+		}
+	}
+
+	Chunk& data{_chunks[std::size_t(chunk.y) * chunkCount().x + chunk.x]};
+	if (!_vertices.empty()) {
+		data.vertexBuffer.set(tr::rangeBytes(_vertices));
+	}
+	data.indices = _vertices.size() / 4 * 6;
+	data.dirty   = false;
+}
+
+void tre::Tilemap::draw(const RenderView& view, int layer)
+{
+	const Renderer2D& renderer{renderer2D()};
+	assert(renderer.layerSampler(layer) != nullptr);
+	const glm::mat4& transform{renderer.layerTransform(layer)};
+
+	// The visible area is found by mapping the corners of clip space back to tilemap space.
+	const glm::mat4 inverse{glm::inverse(transform)};
+	glm::vec2       min{std::numeric_limits<float>::max()};
+	glm::vec2       max{std::numeric_limits<float>::lowest()};
+	for (const glm::vec2 corner : std::initializer_list<glm::vec2>{{-1, -1}, {1, -1}, {-1, 1}, {1, 1}}) {
+		const glm::vec4 point{inverse * glm::vec4{corner, 0, 1}};
+		min = glm::min(min, glm::vec2{point} / point.w);
+		max = glm::max(max, glm::vec2{point} / point.w);
+	}
+	const glm::vec2  chunkSize{_tileSize * float(CHUNK_SIZE)};
+	const glm::ivec2 chunks{chunkCount()};
+	const glm::ivec2 first{glm::clamp(glm::ivec2{glm::floor(min / chunkSize)}, glm::ivec2{0}, chunks)};
+	const glm::ivec2 last{glm::clamp(glm::ivec2{glm::ceil(max / chunkSize)}, glm::ivec2{0}, chunks)};
+	if (first.x >= last.x || first.y >= last.y) {
+		return;
+	}
+
+	graphicsState().setTexture(_textureUnit, _atlas.get().texture());
+	graphicsState().setSampler(_textureUnit, *renderer.layerSampler(layer));
+	_shaderPipeline.vertexShader().setUniform(0, transform);
+	setupContext(renderer.layerBlendMode(layer));
+	view.use();
+
+	for (int y = first.y; y < last.y; ++y) {
+		for (int x = first.x; x < last.x; ++x) {
+			if (_chunks[std::size_t(y) * chunks.x + x].dirty) {
+				rebuildChunk({x, y});
+			}
+			const Chunk& chunk{_chunks[std::size_t(y) * chunks.x + x]};
+			if (chunk.indices != 0) {
+				tr::window().graphics().setVertexBuffer(chunk.vertexBuffer, 0, sizeof(tr::TintVtx2));
+				tr::window().graphics().drawIndexed(tr::Primitive::TRIS, 0, chunk.indices);
+			}
+		}
+	}
+}
+
+void tre::Tilemap::setupContext(const tr::BlendMode& blendMode) noexcept
+{
+	GraphicsStateCache& state{graphicsState()};
+	state.useFaceCulling(false);
+	state.useDepthTest(false);
+	state.useStencilTest(false);
+	state.useBlending(true);
+	state.setBlendingMode(blendMode);
+	state.setShaderPipeline(_shaderPipeline);
+	state.setVertexFormat(tr::TintVtx2::vertexFormat());
+	tr::window().graphics().setIndexBuffer(_indexBuffer);
+}
\ No newline at end of file
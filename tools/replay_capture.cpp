@@ -0,0 +1,44 @@
+// Replays frame captures saved with tre::Renderer2D::FrameCapture::save() on the null graphics backend, printing the
+// statistics of every replayed frame. Captures saved one after another in the same file are replayed in order.
+//
+// Usage: tre_replay_capture <capture file>
+
+#include <tre/renderer_2d.hpp>
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+	if (argc != 2) {
+		std::cerr << "Usage: tre_replay_capture <capture file>\n";
+		return EXIT_FAILURE;
+	}
+	std::ifstream is{argv[1], std::ios::binary};
+	if (!is.is_open()) {
+		std::cerr << std::format("Failed to open '{}'.\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	tre::Renderer2D renderer{tre::NULL_GRAPHICS};
+	try {
+		for (std::size_t frame = 0; is.peek() != std::ifstream::traits_type::eof(); ++frame) {
+			const tre::Renderer2D::FrameCapture capture{is};
+			renderer.clearRecordedCalls();
+			renderer.replayFrame(capture);
+			renderer.prepare();
+			renderer.drawPrepared(tre::NULL_GRAPHICS);
+
+			const tre::Renderer2D::Stats& stats{renderer.stats()};
+			std::cout << std::format("Frame {}: {} primitives, {} draw calls, {} vertices, {} indices, {} bytes "
+									 "uploaded, {} texture changes, {} blending mode changes, {} graphics calls\n",
+									 frame, capture.primitiveCount(), stats.drawCalls, stats.vertices, stats.indices,
+									 stats.uploadedBytes, stats.textureChanges, stats.blendModeChanges,
+									 renderer.recordedCalls().size());
+		}
+	}
+	catch (std::exception& err) {
+		std::cerr << std::format("Failed to replay '{}': {}\n", argv[1], err.what());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
\ No newline at end of file